@@ -0,0 +1,337 @@
+/*
+ * File: PublishBenchmarks.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <tahu.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Node.h"
+#include "Device.h"
+#include "metrics/simple/Int32Metric.h"
+#include "metrics/simple/DoubleMetric.h"
+#include "metrics/complex/DataSetMetric.h"
+#include "utils/BenchmarkClient.h"
+#include "utils/Protobuf.h"
+
+/**
+ * @brief Creates a Device populated with Int32 metrics
+ */
+static std::unique_ptr<Device> createDevice(const std::string &name, int metricCount, std::vector<std::shared_ptr<Int32Metric>> &metrics)
+{
+    auto device = std::make_unique<Device>(name.c_str(), 1);
+    for (int i = 0; i < metricCount; i++)
+    {
+        auto metric = Int32Metric::create(("Metrics/Metric " + std::to_string(i)).c_str(), 0);
+        metrics.push_back(metric);
+        device->addMetric(metric);
+    }
+    return device;
+}
+
+static void BM_MetricSetValue(benchmark::State &state)
+{
+    auto metric = DoubleMetric::create("Metric", 0.0);
+    double value = 0.0;
+
+    for (auto _ : state)
+    {
+        metric->setValue(value);
+        value += 1.0;
+        metric->published();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricSetValue);
+
+static void BM_PublishableAddToPayload(benchmark::State &state)
+{
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+    auto device = createDevice("Device", state.range(0), metrics);
+    int dirtyCount = state.range(1);
+    int32_t value = 0;
+
+    for (auto _ : state)
+    {
+        value++;
+        for (int i = 0; i < dirtyCount; i++)
+        {
+            metrics[i]->setValue(value);
+        }
+
+        org_eclipse_tahu_protobuf_Payload payload;
+        memset(&payload, 0, sizeof(payload));
+        device->addToPayload(&payload);
+        benchmark::DoNotOptimize(payload.metrics_count);
+        free_payload(&payload);
+        device->published();
+    }
+    state.SetItemsProcessed(state.iterations() * dirtyCount);
+}
+BENCHMARK(BM_PublishableAddToPayload)->Args({100, 10})->Args({1000, 10})->Args({1000, 1000})->Args({10000, 100});
+
+static void BM_PublishableUpdateMetrics(benchmark::State &state)
+{
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+    auto device = createDevice("Device", state.range(0), metrics);
+    bool batched = state.range(1);
+    int32_t value = 0;
+
+    std::vector<MetricUpdate<int32_t>> updates;
+    for (auto &metric : metrics)
+    {
+        updates.push_back({metric.get(), 0});
+    }
+
+    for (auto _ : state)
+    {
+        value++;
+        if (batched)
+        {
+            for (auto &update : updates)
+            {
+                update.value = value;
+            }
+            device->updateMetrics(updates);
+        }
+        else
+        {
+            for (auto &metric : metrics)
+            {
+                metric->setValue(value);
+            }
+        }
+        device->published();
+    }
+    state.SetItemsProcessed(state.iterations() * metrics.size());
+}
+BENCHMARK(BM_PublishableUpdateMetrics)->Args({5000, 0})->Args({5000, 1});
+
+static void BM_PublishableBirth(benchmark::State &state)
+{
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+    auto device = createDevice("Device", state.range(0), metrics);
+    bool cached = state.range(1);
+    std::vector<uint8_t> buffer(MAX_BUFFER_LENGTH);
+    size_t length = 0;
+
+    for (auto &metric : metrics)
+    {
+        metric->enableBirthCache(cached);
+    }
+
+    for (auto _ : state)
+    {
+        // A rebirth where a handful of metrics changed since the last birth
+        metrics[0]->setValue(metrics[0]->getValue() + 1);
+
+        device->encodeBirth(buffer, TimeManager::getTime());
+        length = buffer.size();
+        device->published();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PublishableBirth)->Args({1000, 0})->Args({1000, 1});
+
+static void BM_DataSetEncode(benchmark::State &state)
+{
+    auto dataSet = DataSetMetric::create("DataSet", {
+                                                        {"Time", DATA_SET_DATA_TYPE_DATETIME},
+                                                        {"Reading", DATA_SET_DATA_TYPE_DOUBLE},
+                                                        {"Valid", DATA_SET_DATA_TYPE_BOOLEAN},
+                                                        {"Label", DATA_SET_DATA_TYPE_STRING},
+                                                    });
+    int rows = state.range(0);
+    bool streamed = state.range(1);
+    for (int i = 0; i < rows; i++)
+    {
+        dataSet->appendRow(i, i * 0.5, true, "Label " + std::to_string(i));
+    }
+    std::vector<uint8_t> buffer;
+    int row = 0;
+
+    for (auto _ : state)
+    {
+        row = (row + 1) % rows;
+        dataSet->setCell(row, 1, row * 0.25);
+
+        buffer.clear();
+        if (streamed)
+        {
+            pb_ostream_t stream = protobufStreamFromVector(buffer);
+            dataSet->encode(&stream);
+        }
+        else
+        {
+            org_eclipse_tahu_protobuf_Payload payload;
+            memset(&payload, 0, sizeof(payload));
+            dataSet->addToPayload(&payload);
+            buffer.resize(encode_payload(NULL, 0, &payload));
+            encode_payload(buffer.data(), buffer.size(), &payload);
+            free_payload(&payload);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+        dataSet->published();
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_DataSetEncode)->Args({100, 0})->Args({100, 1})->Args({10000, 0})->Args({10000, 1});
+
+static void BM_ProcessRequest(benchmark::State &state)
+{
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+    auto device = createDevice("Device", state.range(0), metrics);
+    bool isBirth = state.range(1);
+
+    ClientTopicOptions topics = {"", "", "", ""};
+    NullEventHandler handler;
+    BenchmarkClient client(&handler, NULL);
+    client.configure(&topics);
+    client.connect();
+
+    std::string topic = "spBv1.0/Group/DDATA/Node/Device";
+    PublishRequest request(isBirth, (Publishable *)device.get(), &topic, -1, 0);
+    int32_t value = 0;
+
+    for (auto _ : state)
+    {
+        if (!isBirth)
+        {
+            value++;
+            for (auto &metric : metrics)
+            {
+                metric->setValue(value);
+            }
+        }
+
+        // Each publish is a new request, so the cached encoding from the previous iteration is dropped
+        request.encodedLength = 0;
+        benchmark::DoNotOptimize(client.encode(&request));
+        device->published();
+    }
+    state.SetBytesProcessed(client.bytesPublished);
+    state.SetItemsProcessed(state.iterations() * metrics.size());
+}
+BENCHMARK(BM_ProcessRequest)->Args({100, 0})->Args({1000, 0})->Args({1000, 1});
+
+static void BM_HandleCommand(benchmark::State &state)
+{
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+    auto device = createDevice("Device", state.range(0), metrics);
+    int commandCount = state.range(1);
+    int64_t received = 0;
+
+    for (auto &metric : metrics)
+    {
+        metric->setCommandCallback([&received](__attribute__((unused)) Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                                   { received += payload->value.int_value; });
+    }
+
+    // Commands address the most recently added metrics, the worst case for list searches
+    org_eclipse_tahu_protobuf_Payload payload;
+    memset(&payload, 0, sizeof(payload));
+    for (int i = 0; i < commandCount; i++)
+    {
+        org_eclipse_tahu_protobuf_Payload_Metric command;
+        int32_t value = i;
+        init_metric(&command, metrics[i]->getName(), false, 0, METRIC_DATA_TYPE_INT32, false, false, &value, sizeof(value));
+        add_metric_to_payload(&payload, &command);
+    }
+
+    size_t length = encode_payload(NULL, 0, &payload);
+    std::vector<uint8_t> buffer(length);
+    encode_payload(buffer.data(), length, &payload);
+    free_payload(&payload);
+
+    for (auto _ : state)
+    {
+        ((Publishable *)device.get())->handleCommand(NULL, buffer.data(), length);
+    }
+    benchmark::DoNotOptimize(received);
+    state.SetItemsProcessed(state.iterations() * commandCount);
+}
+BENCHMARK(BM_HandleCommand)->Args({100, 10})->Args({10000, 10})->Args({10000, 1000});
+
+static void BM_NodeExecute(benchmark::State &state)
+{
+    int deviceCount = state.range(0);
+    int metricCount = state.range(1);
+    int workerThreads = state.range(2);
+
+    NodeOptions nodeOptions = {"Group", "Node", "", 1, NODE_CONTROL_NONE};
+    Node node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = "tcp://localhost:1883",
+        .clientId = "benchmark",
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5,
+        .maxInflight = 0};
+
+    BenchmarkClient *client = node.addClient<BenchmarkClient>(&clientOptions);
+
+    std::vector<std::unique_ptr<Device>> devices;
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+
+    for (int i = 0; i < deviceCount; i++)
+    {
+        devices.push_back(createDevice("Device " + std::to_string(i), metricCount, metrics));
+        node.addDevice(devices.back().get());
+    }
+
+    node.setWorkerThreads(workerThreads);
+    node.enable();
+
+    // Connect, activate and birth before measuring
+    node.execute(0);
+    node.execute(0);
+
+    int32_t value = 0;
+
+    for (auto _ : state)
+    {
+        value++;
+        for (auto &metric : metrics)
+        {
+            metric->setValue(value);
+        }
+        node.execute(1);
+        node.sync();
+    }
+    state.SetBytesProcessed(client->bytesPublished);
+    state.SetItemsProcessed(state.iterations() * metrics.size());
+}
+BENCHMARK(BM_NodeExecute)->Args({10, 100, 0})->Args({100, 100, 0})->Args({500, 20, 0})->Args({100, 100, 3})->Args({500, 20, 3})->UseRealTime();
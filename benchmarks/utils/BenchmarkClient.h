@@ -0,0 +1,153 @@
+/*
+ * File: BenchmarkClient.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef BENCHMARKS_UTILS_BENCHMARKCLIENT
+#define BENCHMARKS_UTILS_BENCHMARKCLIENT
+
+#include "clients/SparkplugClient.h"
+
+/**
+ * @brief Event handler that discards all client events, for benchmarking a client without a Node.
+ */
+class NullEventHandler : public ClientEventHandler
+{
+public:
+    virtual void onEvent(__attribute__((unused)) SparkplugClient *client, EventType eventType, void *data) override
+    {
+        if (eventType == CLIENT_UNDELIVERED)
+        {
+            SparkplugClient::destroyRequest((PublishRequest *)data);
+        }
+    }
+};
+
+/**
+ * @brief A SparkplugClient that never touches the network.
+ * Requests are encoded as normal and immediately acknowledged, letting benchmarks measure the
+ * library without broker round trips.
+ */
+class BenchmarkClient : public SparkplugClient
+{
+private:
+    bool clientConnected = false;
+
+protected:
+    virtual int clientConnect() override
+    {
+        clientConnected = true;
+        connected();
+        return 0;
+    }
+
+    virtual int clientDisconnect() override
+    {
+        clientConnected = false;
+        disconnected("Benchmark disconnect");
+        return 0;
+    }
+
+    virtual int subscribeToPrimaryHost() override
+    {
+        return 0;
+    }
+
+    virtual int subscribeToCommands() override
+    {
+        activated();
+        return 0;
+    }
+
+    virtual int unsubscribeToCommands() override
+    {
+        return 0;
+    }
+
+    virtual int publishMessage(__attribute__((unused)) const std::string &topic, __attribute__((unused)) uint8_t *buffer, size_t length, DeliveryToken *token) override
+    {
+        bytesPublished += length;
+        *token = ++lastToken;
+        return 0;
+    }
+
+    virtual int configureClient(__attribute__((unused)) ClientOptions *options) override
+    {
+        return 0;
+    }
+
+public:
+    size_t bytesPublished = 0;
+    DeliveryToken lastToken = 0;
+
+    BenchmarkClient() : SparkplugClient() {}
+    BenchmarkClient(ClientEventHandler *handler, ClientOptions *options) : SparkplugClient(handler, options) {}
+
+    /**
+     * @brief Encodes and publishes a request, then acknowledges it straight away.
+     *
+     * @param publishRequest
+     * @return int
+     */
+    virtual int request(PublishRequest *publishRequest) override
+    {
+        int returnCode = processRequest(publishRequest);
+        if (returnCode == 0)
+        {
+            delivered(publishRequest);
+        }
+        else
+        {
+            undelivered(publishRequest);
+        }
+        return returnCode;
+    }
+
+    /**
+     * @brief Exposes the encode path without acknowledging the request.
+     *
+     * @param publishRequest
+     * @return int
+     */
+    int encode(PublishRequest *publishRequest)
+    {
+        return processRequest(publishRequest);
+    }
+
+    virtual void sync() override
+    {
+    }
+
+    virtual bool isConnected() override
+    {
+        return clientConnected;
+    }
+};
+
+#endif /* BENCHMARKS_UTILS_BENCHMARKCLIENT */
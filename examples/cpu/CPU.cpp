@@ -180,6 +180,10 @@ CPU::CPU(const char *name) : device(Device(name, 1000))
     usageMetric = DoubleMetric::create("usage", 0.00);
     idleMetric = DoubleMetric::create("idle", 0.00);
 
+    // Only report usage changes larger than half a percent
+    usageMetric->setDeadband(0.5);
+    idleMetric->setDeadband(0.5);
+
     device.addMetric(usageMetric);
     device.addMetric(idleMetric);
 }
@@ -33,19 +33,28 @@
 #define SRC_COMMONTYPES
 
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 class Publishable;
 
 typedef int DeliveryToken;
 
+class PublishRequestPool;
+
 /**
  * @brief Struct for handling the data required for publishing requests.
+ * The topic references the precomputed topic of the publisher, which must outlive the request.
+ * A request may carry a payload that was encoded ahead of time, without a sequence number. The sequence
+ * number is appended by the client when the payload is sent, so the buffer is reused across pooled requests.
+ * The request and send times are used for statistics, and are 0 when not recorded.
  */
 struct PublishRequest
 {
+    PublishRequest() : PublishRequest(false, NULL, NULL, -1, 0){};
     PublishRequest(bool isBirth,
                    Publishable *publisher,
-                   std::string topic,
+                   const std::string *topic,
                    DeliveryToken token,
                    int retryCount) : isBirth(isBirth),
                                      publisher(publisher),
@@ -54,9 +63,14 @@ struct PublishRequest
                                      retryCount(retryCount){};
     bool isBirth;
     Publishable *publisher;
-    std::string topic;
+    const std::string *topic;
     DeliveryToken token;
     int retryCount;
+    PublishRequestPool *pool = NULL;
+    std::vector<uint8_t> encoded;
+    size_t encodedLength = 0;
+    uint64_t requestTime = 0;
+    uint64_t sendTime = 0;
 };
 
 /**
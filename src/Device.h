@@ -84,11 +84,14 @@ public:
     using Publishable::addMetric;
     using Publishable::addMetrics;
     using Publishable::addToPayload;
+    using Publishable::encodeBirth;
+    using Publishable::encodeData;
     using Publishable::canPublish;
     using Publishable::getName;
     using Publishable::published;
     using Publishable::publishing;
     using Publishable::update;
+    using Publishable::updateMetrics;
 };
 
 #endif /* SRC_DEVICE */
@@ -67,6 +67,8 @@ using namespace std;
 #define NODE_CONTROL_REBOOT_NAME "Node Control/Reboot"
 #define NODE_CONTROL_NEXT_SERVER_NAME "Node Control/Next Server"
 
+#define NODE_STATISTICS_PREFIX "Node Statistics/"
+
 #ifdef DEBUGGING
 #define LOGGER(format, ...) \
     printf("Node: ");       \
@@ -83,6 +85,8 @@ Node::Node() : Node(NULL)
 
 Node::Node(NodeOptions *options) : Publishable()
 {
+    Publishable::setOwner(this);
+
     if (options != NULL)
     {
         Publishable::setPublishPeriod(options->publishPeriod);
@@ -116,9 +120,6 @@ Node::~Node()
     {
         delete client;
     }
-#ifdef _GLIBCXX_HAS_GTHREADS
-    delete queueMutex;
-#endif
 }
 
 int Node::enable()
@@ -184,20 +185,33 @@ void Node::configureTopics(const std::string &groupId, const std::string &nodeId
             deviceCommandTopic,
             primaryHostTopic};
 
+        string nodeBirthTopic, nodeDataTopic;
+
+        nodeBirthTopic.append(groupBaseTopic).append(NBIRTH).append("/").append(nodeId);
+        nodeDataTopic.append(groupBaseTopic).append(NDATA).append("/").append(nodeId);
+
+        setTopics(nodeBirthTopic, nodeDataTopic);
+
         topicsConfigured = true;
     }
 }
 
 int Node::requestPublish(Publishable *publishable, bool isBirth)
 {
+    wake();
+
     if (this == publishable)
     {
         return publish(publishable, isBirth);
     }
-    else if (any_of(devices.begin(), devices.end(), [publishable](Device *device)
-                    { return publishable == (Publishable *)device; }))
+    else if (publishable->getName() != NULL)
     {
-        return publish(publishable, isBirth);
+        auto result = deviceRegistry.find(publishable->getName());
+
+        if (result != deviceRegistry.end() && (Publishable *)result->second == publishable)
+        {
+            return publish(publishable, isBirth);
+        }
     }
     return 0;
 }
@@ -220,29 +234,12 @@ int Node::publish(Publishable *publishable, bool isBirth)
 
     publishable->publishing();
 
-    string topic;
-    if (publishable == this)
-    {
-        topic.append(groupBaseTopic)
-            .append((isBirth ? NBIRTH : NDATA))
-            .append("/")
-            .append(nodeId);
-    }
-    else
-    {
-        topic.append(groupBaseTopic)
-            .append(isBirth ? DBIRTH : DDATA)
-            .append("/")
-            .append(nodeId)
-            .append("/")
-            .append(publishable->getName());
-    }
-    PublishRequest *publishRequest = new PublishRequest(
+    PublishRequest *publishRequest = requestPool.acquire(
         isBirth,
         publishable,
-        topic,
-        -1,
-        0);
+        &publishable->getTopic(isBirth));
+
+    statistics.publishRequests.add();
 
     return getActiveClient()->request(publishRequest);
 }
@@ -321,16 +318,50 @@ int32_t Node::execute(int32_t executeTime)
 
     if (!isActive())
     {
+#ifdef CPP_SPARKPLUG_SPOOL
+        if (spool.isOpen())
+        {
+            return min(spoolData(executeTime), (int32_t)EXECUTE_IDLE_DELAY);
+        }
+#endif
         return EXECUTE_IDLE_DELAY;
     }
 
+    uint64_t executeStart = statisticsTime();
     int32_t nextExecute = 0xFFFF;
     nextExecute = min(update(executeTime), nextExecute);
+    updateStatisticsMetrics();
     if (canPublish())
     {
         publish(this);
     }
 
+#ifdef _GLIBCXX_HAS_GTHREADS
+    if (!deviceShards.empty())
+    {
+        nextExecute = min(executeShards(executeTime), nextExecute);
+    }
+    else
+    {
+        nextExecute = min(executeDevices(executeTime), nextExecute);
+    }
+#else
+    nextExecute = min(executeDevices(executeTime), nextExecute);
+#endif
+
+#ifdef CPP_SPARKPLUG_SPOOL
+    replaySpool();
+#endif
+
+    statistics.executeTime.record(statisticsTime() - executeStart);
+
+    return nextExecute;
+}
+
+int32_t Node::executeDevices(int32_t executeTime)
+{
+    int32_t nextExecute = 0xFFFF;
+
     for_each(devices.begin(), devices.end(),
              [this, executeTime, &nextExecute](Device *device)
              {
@@ -345,6 +376,234 @@ int32_t Node::execute(int32_t executeTime)
     return nextExecute;
 }
 
+ssize_t Node::encodePublishable(Publishable *publishable, vector<uint8_t> &buffer)
+{
+    if (publishable->encodeData(buffer, TimeManager::getTime()) != 0)
+    {
+        return -1;
+    }
+    return buffer.size();
+}
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+void Node::setWorkerThreads(size_t count)
+{
+    workers.resize(count);
+    shardDevices();
+}
+
+void Node::shardDevices()
+{
+    deviceShards.clear();
+    shardEntries.clear();
+    deviceCount = 0;
+
+    size_t shardCount = workers.concurrency();
+
+    if (shardCount <= 1)
+    {
+        return;
+    }
+
+    deviceShards.resize(shardCount);
+
+    // Devices are dealt out in turn so each shard holds a similar number of Devices
+    for (auto device : devices)
+    {
+        deviceShards[deviceCount % shardCount].entries.push_back({device, false, false, 0, 0, {}});
+        deviceCount++;
+    }
+
+    for (auto &shard : deviceShards)
+    {
+        for (auto &entry : shard.entries)
+        {
+            shardEntries[(Publishable *)entry.device] = &entry;
+        }
+    }
+}
+
+int32_t Node::executeShards(int32_t executeTime)
+{
+    for (auto &shard : deviceShards)
+    {
+        for (auto &entry : shard.entries)
+        {
+            entry.due = true;
+            entry.elapsed = executeTime;
+        }
+    }
+
+    return executeDueShards();
+}
+
+int32_t Node::executeDueShards()
+{
+    workers.run([this](size_t index)
+                {
+        DeviceShard &shard = deviceShards[index];
+        shard.nextExecute = 0xFFFF;
+
+        for (auto &entry : shard.entries)
+        {
+            if (!entry.due)
+            {
+                continue;
+            }
+
+            Publishable *publishable = (Publishable *)entry.device;
+
+            entry.nextExecute = publishable->update(entry.elapsed);
+            shard.nextExecute = min(entry.nextExecute, shard.nextExecute);
+            entry.publishing = publishable->canPublish();
+
+            if (entry.publishing)
+            {
+                publishable->publishing();
+                encodePublishable(publishable, entry.encoded);
+            }
+        } });
+
+    int32_t nextExecute = 0xFFFF;
+    size_t shardCount = deviceShards.size();
+
+    for (auto &shard : deviceShards)
+    {
+        nextExecute = min(shard.nextExecute, nextExecute);
+    }
+
+    // Requests are sent in Device order, so the client assigns sequence numbers in the same order as the serial execute
+    for (size_t i = 0; i < deviceCount; i++)
+    {
+        ShardEntry &entry = deviceShards[i % shardCount].entries[i / shardCount];
+
+        if (!entry.due || !entry.publishing)
+        {
+            entry.due = false;
+            continue;
+        }
+
+        entry.due = false;
+
+        Publishable *publishable = (Publishable *)entry.device;
+
+        PublishRequest *publishRequest = requestPool.acquire(
+            false,
+            publishable,
+            &publishable->getTopic(false));
+
+        // The request takes the encoded payload, and its previous buffer is kept for the next encode.
+        // A payload that failed to encode is left empty, and is encoded by the client instead.
+        publishRequest->encoded.swap(entry.encoded);
+        publishRequest->encodedLength = publishRequest->encoded.size();
+
+        statistics.publishRequests.add();
+        getActiveClient()->request(publishRequest);
+    }
+
+    return nextExecute;
+}
+#endif
+
+#ifdef CPP_SPARKPLUG_SPOOL
+int Node::enableSpool(const char *directory, size_t maxBytes)
+{
+    return spool.open(directory, maxBytes);
+}
+
+int32_t Node::spoolData(int32_t executeTime)
+{
+    int32_t nextExecute = 0xFFFF;
+    nextExecute = min(update(executeTime), nextExecute);
+    if (canPublish())
+    {
+        spoolPublishable(this);
+    }
+
+    for_each(devices.begin(), devices.end(),
+             [this, executeTime, &nextExecute](Device *device)
+             {
+                 nextExecute = min(device->update(executeTime), nextExecute);
+
+                 if (device->canPublish())
+                 {
+                     spoolPublishable((Publishable *)device);
+                 }
+             });
+
+    return nextExecute;
+}
+
+void Node::spoolPublishable(Publishable *publishable)
+{
+    publishable->publishing();
+
+    ssize_t length = encodePublishable(publishable, spoolBuffer);
+
+    if (length <= 0)
+    {
+        LOGGER("Failed to encode spooled data\n");
+    }
+    else
+    {
+        spoolPayload(publishable, publishable->getTopic(false), spoolBuffer.data(), length);
+    }
+
+    // The data has been handed to the spool, it will be delivered once it is replayed
+    publishable->published();
+}
+
+void Node::spoolPayload(Publishable *publishable, const std::string &topic, const uint8_t *payload, size_t length)
+{
+    if (publishable->nameEncodedData(payload, length, spoolRecord) != 0 ||
+        spool.append(topic, spoolRecord.data(), spoolRecord.size()) != 0)
+    {
+        LOGGER("Failed to spool data\n");
+    }
+}
+
+void Node::replaySpool()
+{
+    SparkplugClient *client = getActiveClient();
+
+    if (replaying || client == NULL || !client->isConnected())
+    {
+        return;
+    }
+
+    std::string_view topic;
+    const uint8_t *payload;
+    size_t length;
+
+    if (!spool.peek(topic, payload, length))
+    {
+        return;
+    }
+
+    spooledPublishable.setRecord(topic, payload, length);
+    replaying = true;
+
+    PublishRequest *publishRequest = requestPool.acquire(
+        false,
+        (Publishable *)&spooledPublishable,
+        &spooledPublishable.getTopic(false));
+
+    client->request(publishRequest);
+}
+#endif
+
+/**
+ * @brief Monotonic time in milliseconds used to schedule publishes
+ *
+ * @return uint64_t
+ */
+static uint64_t schedulerTime()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
 void Node::begin()
 {
     if (!enabled)
@@ -355,22 +614,209 @@ void Node::begin()
 
     running = true;
 
-    int32_t nextExecute = 0;
+    schedulePublishables(schedulerTime());
+
+    while (running)
+    {
+        waitForWork(executeScheduled(schedulerTime()));
+    }
+}
+
+void Node::schedulePublishables(uint64_t now)
+{
+    scheduler.reset(now);
+    publishTimers.clear();
+    timersByPublishable.clear();
+
+    publishTimers.emplace_front();
+    publishTimers.front().publishable = this;
+
+    for (auto device : devices)
+    {
+        publishTimers.emplace_front();
+        publishTimers.front().publishable = (Publishable *)device;
+    }
 
-    for (;;)
+    for (auto &timer : publishTimers)
     {
-        if (!running)
+        timer.lastUpdate = now;
+        scheduler.schedule(&timer, now);
+        timersByPublishable[timer.publishable] = &timer;
+    }
+
+    // Every timer is already due, so Publishables that became dirty beforehand need no rescheduling
+    {
+#ifdef _GLIBCXX_HAS_GTHREADS
+        lock_guard<mutex> lock(dirtyMutex);
+#endif
+        dirtyPublishables.clear();
+    }
+}
+
+void Node::rescheduleDirty(uint64_t now)
+{
+    {
+#ifdef _GLIBCXX_HAS_GTHREADS
+        lock_guard<mutex> lock(dirtyMutex);
+#endif
+        rescheduledPublishables.swap(dirtyPublishables);
+    }
+
+    for (auto publishable : rescheduledPublishables)
+    {
+        auto timer = timersByPublishable.find(publishable);
+        if (timer != timersByPublishable.end())
+        {
+            scheduler.schedule(timer->second, now);
+        }
+    }
+    rescheduledPublishables.clear();
+}
+
+void Node::onPublishableDirty(Publishable *publishable)
+{
+    // Only begin holds Publishables back until their timers expire, execute updates every Publishable on each call
+    if (!running)
+    {
+        return;
+    }
+
+    {
+#ifdef _GLIBCXX_HAS_GTHREADS
+        lock_guard<mutex> lock(dirtyMutex);
+#endif
+        dirtyPublishables.push_back(publishable);
+    }
+    wake();
+}
+
+int32_t Node::executeScheduled(uint64_t now)
+{
+    bool active = isActive();
+    bool spooling = false;
+
+#ifdef CPP_SPARKPLUG_SPOOL
+    spooling = !active && spool.isOpen();
+#endif
+
+    if (!active && !spooling)
+    {
+        // Publish timers are held until a client is active
+        return NODE_SCHEDULER_MAX_WAIT;
+    }
+
+    uint64_t executeStart = statisticsTime();
+
+    // A Publishable that can already publish sends its dirty metrics now rather than a publish period later
+    rescheduleDirty(now);
+    TimerWheel::Timer *expired = scheduler.advance(now);
+
+    while (expired != nullptr)
+    {
+        PublishTimer *timer = (PublishTimer *)expired;
+        expired = expired->next;
+
+        Publishable *publishable = timer->publishable;
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+        // Devices held in shards are updated and encoded by the workers once all expired timers are collected
+        if (!deviceShards.empty() && !spooling && publishable != this)
+        {
+            auto entry = shardEntries.find(publishable);
+            if (entry != shardEntries.end())
+            {
+                entry->second->due = true;
+                entry->second->elapsed = now - timer->lastUpdate;
+                timer->lastUpdate = now;
+                shardedTimers.push_back({timer, entry->second});
+                continue;
+            }
+        }
+#endif
+
+        int32_t nextExecute = publishable->update(now - timer->lastUpdate);
+        timer->lastUpdate = now;
+
+        if (publishable == this)
+        {
+            updateStatisticsMetrics();
+        }
+
+        if (publishable->canPublish())
+        {
+#ifdef CPP_SPARKPLUG_SPOOL
+            if (spooling)
+            {
+                spoolPublishable(publishable);
+            }
+            else
+            {
+                publish(publishable);
+            }
+#else
+            publish(publishable);
+#endif
+        }
+
+        scheduler.schedule(timer, now + max(nextExecute, (int32_t)1));
+    }
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+    if (!shardedTimers.empty())
+    {
+        executeDueShards();
+
+        for (auto &sharded : shardedTimers)
         {
-            // Potential check for getting out of an endless loop
-            // Idea is to run this on its own thread
-            return;
+            scheduler.schedule(sharded.first, now + max(sharded.second->nextExecute, (int32_t)1));
         }
+        shardedTimers.clear();
+    }
+#endif
 
-        nextExecute = execute(nextExecute);
-#if defined(__linux__)
-        std::this_thread::sleep_for(std::chrono::seconds(nextExecute));
+#ifdef CPP_SPARKPLUG_SPOOL
+    if (!spooling)
+    {
+        replaySpool();
+    }
 #endif
+
+    statistics.executeTime.record(statisticsTime() - executeStart);
+
+    uint64_t nextDue = scheduler.nextDue();
+
+    if (nextDue <= now)
+    {
+        return 0;
     }
+
+    return (int32_t)min(nextDue - now, (uint64_t)NODE_SCHEDULER_MAX_WAIT);
+}
+
+void Node::waitForWork(int32_t timeout)
+{
+#ifdef _GLIBCXX_HAS_GTHREADS
+    unique_lock<mutex> lock(wakeMutex);
+    wakeCondition.wait_for(lock, std::chrono::milliseconds(timeout), [this]
+                           { return wakePending.load() || !running; });
+    wakePending = false;
+#elif defined(__linux__)
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+#endif
+}
+
+void Node::wake()
+{
+#ifdef _GLIBCXX_HAS_GTHREADS
+    if (!wakePending.exchange(true))
+    {
+        // Taking the lock ensures the waiting thread is either waiting, or will see the flag before it waits
+        {
+            lock_guard<mutex> lock(wakeMutex);
+        }
+        wakeCondition.notify_one();
+    }
+#endif
 }
 
 SparkplugClient *Node::addClient(SparkplugClient *client)
@@ -384,54 +830,118 @@ int Node::nextServer()
     return 0;
 }
 
+void Node::enableStatisticsMetrics()
+{
+    if (statisticsMetricsEnabled)
+    {
+        return;
+    }
+
+    statisticsMetrics.published = UInt64Metric::create(NODE_STATISTICS_PREFIX "Published", 0);
+    statisticsMetrics.delivered = UInt64Metric::create(NODE_STATISTICS_PREFIX "Delivered", 0);
+    statisticsMetrics.undelivered = UInt64Metric::create(NODE_STATISTICS_PREFIX "Undelivered", 0);
+    statisticsMetrics.retries = UInt64Metric::create(NODE_STATISTICS_PREFIX "Retries", 0);
+    statisticsMetrics.bytesPublished = UInt64Metric::create(NODE_STATISTICS_PREFIX "Bytes Published", 0);
+    statisticsMetrics.queueDepth = UInt64Metric::create(NODE_STATISTICS_PREFIX "Queue Depth", 0);
+    statisticsMetrics.queueLatency = UInt64Metric::create(NODE_STATISTICS_PREFIX "Queue Latency P99", 0);
+    statisticsMetrics.deliveryLatency = UInt64Metric::create(NODE_STATISTICS_PREFIX "Delivery Latency P99", 0);
+    statisticsMetrics.eventsOverflowed = UInt64Metric::create(NODE_STATISTICS_PREFIX "Events Overflowed", 0);
+
+    addMetrics({statisticsMetrics.published,
+                statisticsMetrics.delivered,
+                statisticsMetrics.undelivered,
+                statisticsMetrics.retries,
+                statisticsMetrics.bytesPublished,
+                statisticsMetrics.queueDepth,
+                statisticsMetrics.queueLatency,
+                statisticsMetrics.deliveryLatency,
+                statisticsMetrics.eventsOverflowed});
+
+    statisticsMetricsEnabled = true;
+}
+
+void Node::updateStatisticsMetrics()
+{
+    if (!statisticsMetricsEnabled || getState() != CAN_PUBLISH || activeClient == NULL)
+    {
+        return;
+    }
+
+    ClientStatistics &clientStatistics = activeClient->getStatistics();
+
+    statisticsMetrics.published->setValue(clientStatistics.published.get());
+    statisticsMetrics.delivered->setValue(clientStatistics.delivered.get());
+    statisticsMetrics.undelivered->setValue(clientStatistics.undelivered.get());
+    statisticsMetrics.retries->setValue(clientStatistics.retries.get());
+    statisticsMetrics.bytesPublished->setValue(clientStatistics.bytesPublished.get());
+    statisticsMetrics.queueDepth->setValue(clientStatistics.queueDepth.get());
+    statisticsMetrics.queueLatency->setValue(clientStatistics.queueLatency.getPercentile(0.99));
+    statisticsMetrics.deliveryLatency->setValue(clientStatistics.deliveryLatency.getPercentile(0.99));
+    statisticsMetrics.eventsOverflowed->setValue(statistics.eventsOverflowed.get());
+}
+
+NodeStatistics &Node::getStatistics()
+{
+    return statistics;
+}
+
 void Node::addDevice(Device *device)
 {
     devices.push_front(device);
+    ((Publishable *)device)->setOwner(this);
+    if (device->getName() != NULL)
+    {
+        deviceRegistry[device->getName()] = device;
+
+        string deviceBirthTopic, deviceDataTopic;
+
+        deviceBirthTopic.append(groupBaseTopic).append(DBIRTH).append("/").append(nodeId).append("/").append(device->getName());
+        deviceDataTopic.append(groupBaseTopic).append(DDATA).append("/").append(nodeId).append("/").append(device->getName());
+
+        ((Publishable *)device)->setTopics(deviceBirthTopic, deviceDataTopic);
+    }
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+    if (!deviceShards.empty())
+    {
+        shardDevices();
+    }
+#endif
 }
 
-int Node::onMessage(SparkplugClient *client, const std::string &topic, const void *payload, const int payloadLength)
+int Node::onMessage(SparkplugClient *client, std::string_view topic, const void *payload, const int payloadLength)
 {
     if (client == getActiveClient())
     {
-        if (topic.find(NCMD) != std::string::npos)
+        // Device command topics share the subscription topic as a prefix, minus the trailing wildcard
+        const std::string &deviceCommandTopic = clientTopics.deviceCommandTopic;
+        size_t prefixLength = deviceCommandTopic.empty() ? 0 : deviceCommandTopic.size() - 1;
+
+        if (topic.compare(clientTopics.nodeCommandTopic) == 0)
         {
-            if (topic.compare(clientTopics.nodeCommandTopic) == 0)
-            {
-                Publishable::handleCommand(this, payload, payloadLength);
-            }
+            Publishable::handleCommand(this, payload, payloadLength);
         }
-        else if (topic.find(DCMD) != std::string::npos)
+        else if (prefixLength > 0 && topic.size() > prefixLength &&
+                 topic.compare(0, prefixLength, deviceCommandTopic, 0, prefixLength) == 0)
         {
-            if (devices.empty())
-            {
-                return 0;
-            }
+            std::string_view deviceName(topic.data() + prefixLength, topic.size() - prefixLength);
 
-            size_t size = clientTopics.deviceCommandTopic.size() - 1;
+            auto result = deviceRegistry.find(deviceName);
 
-            if (size < topic.size())
+            if (result != deviceRegistry.end())
             {
-                string deviceName = topic.substr(size);
-                forward_list<Device *>::iterator result;
-
-                result = find_if(devices.begin(), devices.end(), [deviceName](Device *device)
-                                 { return deviceName.compare(device->getName()) == 0; });
-
-                if (result != devices.end())
-                {
-                    Publishable *publishable;
-                    publishable = (Publishable *)*result;
-                    // Handle Device Command
-                    publishable->handleCommand(this, payload, payloadLength);
-                }
+                Publishable *publishable;
+                publishable = (Publishable *)result->second;
+                // Handle Device Command
+                publishable->handleCommand(this, payload, payloadLength);
             }
         }
     }
 
     if (!clientTopics.primaryHostTopic.empty() && topic.compare(clientTopics.primaryHostTopic) == 0)
     {
-        std::string json((char *)payload, payloadLength);
-        if (json.find("\"online\": true") != std::string::npos)
+        std::string_view json((const char *)payload, payloadLength);
+        if (json.find("\"online\": true") != std::string_view::npos)
         {
             // Primary Host Online
             if (getActiveClient() != client)
@@ -439,7 +949,7 @@ int Node::onMessage(SparkplugClient *client, const std::string &topic, const voi
                 activateClient(client);
             }
         }
-        else if (json.find("\"online\": false") != std::string::npos)
+        else if (json.find("\"online\": false") != std::string_view::npos)
         {
             if (getActiveClient() == client)
             {
@@ -457,6 +967,9 @@ void Node::stop()
         client->deactivate();
         client->disconnect();
     }
+
+    running = false;
+    wake();
 }
 
 bool Node::isActive()
@@ -484,7 +997,17 @@ void Node::onEvent(SparkplugClient *client, EventType event, void *data)
     {
     case CLIENT_MESSAGE:
     {
-        eventData = new MessageEventStruct(*(MessageEventStruct *)data);
+        MessageEventStruct *message = (MessageEventStruct *)data;
+
+        // Owned messages are moved into the queue, borrowed messages must be copied
+        if (message->isOwned())
+        {
+            eventData = new MessageEventStruct(std::move(*message));
+        }
+        else
+        {
+            eventData = new MessageEventStruct(*message);
+        }
     }
     break;
     case CLIENT_CONNECTED:
@@ -503,79 +1026,143 @@ void Node::onEvent(SparkplugClient *client, EventType event, void *data)
         break;
     }
 
-#ifdef _GLIBCXX_HAS_GTHREADS
-    queueMutex->lock();
-#endif
-
-    eventQueue.push_back({client, event, eventData});
+    ClientEventData queuedEvent = {client, event, eventData};
 
+    // Once the queue has overflowed, all events are pushed to the overflow queue until it has been drained
+    // so that events are not processed out of order
+    if (overflowing.load(std::memory_order_acquire) || !eventQueue.push(queuedEvent))
+    {
 #ifdef _GLIBCXX_HAS_GTHREADS
-    queueMutex->unlock();
+        lock_guard<mutex> lock(overflowMutex);
 #endif
+        // Re-checked under the lock, as the overflow queue may have been drained since the flag was read
+        if (overflowing.load(std::memory_order_acquire) || !eventQueue.push(queuedEvent))
+        {
+            // Flagged before the event is queued, so no later event can be pushed to the queue ahead of it
+            overflowing.store(true, std::memory_order_release);
+            overflowEvents.push_back(queuedEvent);
+            statistics.eventsOverflowed.add();
+        }
+    }
+
+    wake();
 }
 
 void Node::processEvents()
 {
-    while (!eventQueue.empty())
+    ClientEventData batch[NODE_EVENT_BATCH_SIZE];
+    size_t remaining = eventQueue.capacity();
+    size_t count;
+
+    // Drain at most a queue's worth of events so that a busy producer cannot stall the executing thread
+    do
     {
+        count = eventQueue.drain(batch, min((size_t)NODE_EVENT_BATCH_SIZE, remaining));
+        remaining -= count;
 
-#ifdef _GLIBCXX_HAS_GTHREADS
-        queueMutex->lock();
-#endif
+        for (size_t i = 0; i < count; i++)
+        {
+            processEvent(batch[i]);
+        }
+    } while (count == NODE_EVENT_BATCH_SIZE && remaining > 0);
 
-        ClientEventData eventData = eventQueue.front();
-        eventQueue.pop_front();
+    // Overflowed events are newer than anything left in the queue
+    if (count == NODE_EVENT_BATCH_SIZE || !overflowing.load(std::memory_order_acquire))
+    {
+        return;
+    }
 
+    deque<ClientEventData> pending;
+
+    {
 #ifdef _GLIBCXX_HAS_GTHREADS
-        queueMutex->unlock();
+        lock_guard<mutex> lock(overflowMutex);
 #endif
+        pending.swap(overflowEvents);
+        overflowing.store(false, std::memory_order_release);
+    }
 
-        switch (eventData.eventType)
-        {
-        case CLIENT_DELIVERED:
+    for (auto &eventData : pending)
+    {
+        processEvent(eventData);
+    }
+}
+
+void Node::processEvent(ClientEventData &eventData)
+{
+    statistics.eventsProcessed.add();
+
+    switch (eventData.eventType)
+    {
+    case CLIENT_DELIVERED:
+    {
+        Publishable *publishable;
+        publishable = (Publishable *)eventData.data;
+#ifdef CPP_SPARKPLUG_SPOOL
+        if (publishable == (Publishable *)&spooledPublishable)
         {
-            Publishable *publishable;
-            publishable = (Publishable *)eventData.data;
-            publishable->published();
+            // The spooled payload has been delivered, it can be removed and the next one replayed
+            spool.pop();
+            replaying = false;
+            replaySpool();
+            break;
         }
-        break;
-        case CLIENT_UNDELIVERED:
+#endif
+        publishable->published();
+    }
+    break;
+    case CLIENT_UNDELIVERED:
+    {
+        PublishRequest *publishRequest = (PublishRequest *)eventData.data;
+        Publishable *publishable = publishRequest->publisher;
+#ifdef CPP_SPARKPLUG_SPOOL
+        if (publishable == (Publishable *)&spooledPublishable)
         {
-            Publishable *publishable;
-            publishable = (Publishable *)eventData.data;
-            publishable->published();
+            // The spooled payload is kept and replayed again on the next execute
+            replaying = false;
+            SparkplugClient::destroyRequest(publishRequest);
+            break;
         }
-        break;
-        case CLIENT_MESSAGE:
+        // Undelivered data is kept in the spool rather than being lost. Births are not spooled,
+        // the Publishables are reborn once a client is active again.
+        if (spool.isOpen() && !publishRequest->isBirth && publishRequest->encodedLength > 0)
         {
-            MessageEventStruct *messageData = (MessageEventStruct *)eventData.data;
+            spoolPayload(publishable, *publishRequest->topic, publishRequest->encoded.data(), publishRequest->encodedLength);
+        }
+#endif
+        SparkplugClient::destroyRequest(publishRequest);
+        publishable->published();
+    }
+    break;
+    case CLIENT_MESSAGE:
+    {
+        MessageEventStruct *messageData = (MessageEventStruct *)eventData.data;
 
-            onMessage(
-                eventData.client,
-                messageData->topic,
-                messageData->payload, messageData->payloadLength);
+        onMessage(
+            eventData.client,
+            messageData->topic,
+            messageData->payload, messageData->payloadLength);
 
-            // We copy data to our queue, so we must free it
-            delete messageData;
+        // We copy data to our queue, so we must free it
+        delete messageData;
+    }
+    break;
+    case CLIENT_CONNECTED:
+        if (getClientMode() == SINGLE)
+        {
+            activateClient(eventData.client);
         }
         break;
-        case CLIENT_CONNECTED:
-            if (getClientMode() == SINGLE)
-            {
-                activateClient(eventData.client);
-            }
-            break;
-        case CLIENT_DISCONNECTED:
-            deactivateClient(eventData.client);
-            break;
-        case CLIENT_ACTIVE:
-            setActiveClient(eventData.client);
-            break;
-        case CLIENT_DEACTIVE:
-            break;
-        default:
-            break;
-        }
+    case CLIENT_DISCONNECTED:
+        deactivateClient(eventData.client);
+        break;
+    case CLIENT_ACTIVE:
+        setActiveClient(eventData.client);
+        break;
+    case CLIENT_DEACTIVE:
+        break;
+    default:
+        break;
     }
 }
 
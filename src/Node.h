@@ -42,8 +42,24 @@
 #include <deque>
 #include <forward_list>
 #include <mutex>
+#include <atomic>
+#include <string_view>
+#include <unordered_map>
+#ifdef _GLIBCXX_HAS_GTHREADS
+#include <condition_variable>
+#endif
 #include "metrics/simple/BooleanMetric.h"
+#include "metrics/simple/UInt64Metric.h"
 #include "utils/TimeManager.h"
+#include "utils/MpscQueue.h"
+#include "utils/PublishRequestPool.h"
+#include "utils/WorkerPool.h"
+#include "utils/TimerWheel.h"
+#include "utils/Statistics.h"
+#ifdef CPP_SPARKPLUG_SPOOL
+#include "utils/Spool.h"
+#include "SpooledPublishable.h"
+#endif
 
 using namespace std;
 
@@ -56,6 +72,28 @@ using namespace std;
 #define NODE_CONTROL_NEXT_SERVER 0b10
 #define NODE_CONTROL_REBOOT 0b100
 
+/**
+ * @brief The number of client events that can be queued before the Node falls back to a locked overflow queue
+ */
+#ifndef NODE_EVENT_QUEUE_CAPACITY
+#define NODE_EVENT_QUEUE_CAPACITY 256
+#endif
+
+/**
+ * @brief The number of client events drained from the queue in a single pass
+ */
+#ifndef NODE_EVENT_BATCH_SIZE
+#define NODE_EVENT_BATCH_SIZE 32
+#endif
+
+/**
+ * @brief The longest time in milliseconds the Node waits between executes when running with begin.
+ * Bounds how long synchronous clients go without being synced while no publishes are due.
+ */
+#ifndef NODE_SCHEDULER_MAX_WAIT
+#define NODE_SCHEDULER_MAX_WAIT 100
+#endif
+
 #define NodeOptionsInitializer                  \
     {                                           \
         NULL, NULL, NULL, 30, NODE_CONTROL_NONE \
@@ -109,24 +147,215 @@ typedef struct
  * Manages a set of Clients that are used for Publishing.
  * Can run Asynchronous with Asynchronous supported clients.
  */
-class Node : Publishable, ClientEventHandler, Publisher
+class Node : Publishable, ClientEventHandler, Publisher, PublishableOwner
 {
 private:
     std::string groupBaseTopic;
     std::string nodeId;
     ClientTopicOptions clientTopics;
     bool topicsConfigured = false;
-    bool running = false;
+    std::atomic<bool> running = false;
     bool enabled = false;
     SparkplugClient *activeClient = NULL;
     SparkplugClientMode hostMode;
     vector<SparkplugClient *> clients;
     forward_list<Device *> devices;
-    deque<ClientEventData> eventQueue;
+    unordered_map<std::string_view, Device *> deviceRegistry;
+    MpscQueue<ClientEventData, NODE_EVENT_QUEUE_CAPACITY> eventQueue;
+    deque<ClientEventData> overflowEvents;
+    PublishRequestPool requestPool;
+    NodeStatistics statistics;
+
+    /**
+     * @brief Metrics published by the Node that report the statistics of the Node and its active client
+     */
+    typedef struct
+    {
+        std::shared_ptr<UInt64Metric> published;
+        std::shared_ptr<UInt64Metric> delivered;
+        std::shared_ptr<UInt64Metric> undelivered;
+        std::shared_ptr<UInt64Metric> retries;
+        std::shared_ptr<UInt64Metric> bytesPublished;
+        std::shared_ptr<UInt64Metric> queueDepth;
+        std::shared_ptr<UInt64Metric> queueLatency;
+        std::shared_ptr<UInt64Metric> deliveryLatency;
+        std::shared_ptr<UInt64Metric> eventsOverflowed;
+    } StatisticsMetrics;
+
+    StatisticsMetrics statisticsMetrics;
+    bool statisticsMetricsEnabled = false;
+
+    /**
+     * @brief Updates the statistics metrics of the Node when it is due to publish, so the
+     * statistics are sampled once per publish period
+     */
+    void updateStatisticsMetrics();
+
+#ifdef CPP_SPARKPLUG_SPOOL
+    Spool spool;
+    SpooledPublishable spooledPublishable;
+    std::vector<uint8_t> spoolBuffer;
+    std::vector<uint8_t> spoolRecord;
+    bool replaying = false;
+
+    /**
+     * @brief Updates all Publishables while the Node is offline, writing any data that is ready to publish to the spool.
+     *
+     * @param executeTime
+     * @return int32_t the minimum time before any Publishable needs to Publish again.
+     */
+    int32_t spoolData(int32_t executeTime);
+    /**
+     * @brief Encodes the data of a Publishable and appends it to the spool
+     *
+     * @param publishable
+     */
+    void spoolPublishable(Publishable *publishable);
+    /**
+     * @brief Appends an encoded data payload of a Publishable to the spool, naming its metrics so that the record
+     * can be replayed after a restart, when the aliases of the metrics may have changed.
+     *
+     * @param publishable The Publishable the payload was encoded from
+     * @param topic The topic the payload is published on
+     * @param payload The encoded payload, without a sequence number
+     * @param length The length of the payload
+     */
+    void spoolPayload(Publishable *publishable, const std::string &topic, const uint8_t *payload, size_t length);
+    /**
+     * @brief Publishes the oldest spooled payload through the active client.
+     * Only a single spooled payload is published at a time, the next is published once it has been delivered.
+     */
+    void replaySpool();
+#endif
+    std::atomic<bool> overflowing = false;
 
 #ifdef _GLIBCXX_HAS_GTHREADS
-    mutex *queueMutex = new mutex();
+    mutex overflowMutex;
+    mutex wakeMutex;
+    condition_variable wakeCondition;
+    std::atomic<bool> wakePending = false;
+
+    /**
+     * @brief A Device assigned to a shard, along with the payload encoded for it by a worker.
+     * Only entries that are due are updated by the workers.
+     */
+    typedef struct
+    {
+        Device *device;
+        bool due;
+        bool publishing;
+        int32_t elapsed;
+        int32_t nextExecute;
+        vector<uint8_t> encoded;
+    } ShardEntry;
+
+    /**
+     * @brief A set of Devices that are updated and encoded by a single worker
+     */
+    typedef struct
+    {
+        vector<ShardEntry> entries;
+        int32_t nextExecute;
+    } DeviceShard;
+
+    WorkerPool workers;
+    vector<DeviceShard> deviceShards;
+    unordered_map<Publishable *, ShardEntry *> shardEntries;
+    size_t deviceCount = 0;
+
+    /**
+     * @brief Assigns the Devices of the Node to shards, one shard per worker
+     */
+    void shardDevices();
+    /**
+     * @brief Updates the Devices across the worker threads, with each worker encoding the data payloads of the Devices in its shard.
+     * The encoded payloads are handed to the active client in Device order once all workers have finished, so sequence numbers
+     * are assigned in the same order as the serial execute.
+     *
+     * @param executeTime
+     * @return int32_t the minimum time before any Device needs to Publish again.
+     */
+    int32_t executeShards(int32_t executeTime);
+    /**
+     * @brief Updates the Devices whose shard entries are due across the worker threads, then hands their encoded payloads
+     * to the active client in Device order.
+     *
+     * @return int32_t the minimum time before any of the due Devices needs to Publish again.
+     */
+    int32_t executeDueShards();
 #endif
+
+    /**
+     * @brief The publish timer of a Publishable, scheduled for when the Publishable is next due to publish
+     */
+    struct PublishTimer : TimerWheel::Timer
+    {
+        Publishable *publishable;
+        uint64_t lastUpdate;
+    };
+
+    TimerWheel scheduler;
+    forward_list<PublishTimer> publishTimers;
+    unordered_map<Publishable *, PublishTimer *> timersByPublishable;
+#ifdef _GLIBCXX_HAS_GTHREADS
+    /**
+     * @brief The expired publish timers of Devices that are being updated by the workers
+     */
+    vector<std::pair<PublishTimer *, ShardEntry *>> shardedTimers;
+#endif
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+    mutex dirtyMutex;
+#endif
+    vector<Publishable *> dirtyPublishables;
+    vector<Publishable *> rescheduledPublishables;
+
+    /**
+     * @brief Creates a publish timer for the Node and each Device, all due immediately
+     *
+     * @param now The current time in milliseconds
+     */
+    void schedulePublishables(uint64_t now);
+    /**
+     * @brief Updates only the Publishables whose publish timers have expired, publishing them if they are ready
+     * and scheduling their timers again for when they are next due.
+     *
+     * @param now The current time in milliseconds
+     * @return int32_t the time before the next publish timer is due, capped to NODE_SCHEDULER_MAX_WAIT.
+     */
+    int32_t executeScheduled(uint64_t now);
+    /**
+     * @brief Moves the publish timers of the Publishables that have become dirty since the last pass to now,
+     * so their metrics are published without waiting for their timers to expire.
+     *
+     * @param now The current time in milliseconds
+     */
+    void rescheduleDirty(uint64_t now);
+    /**
+     * @brief Blocks until the timeout passes, or the Node is woken by a client event or publish request
+     *
+     * @param timeout The time to wait in milliseconds
+     */
+    void waitForWork(int32_t timeout);
+    /**
+     * @brief Wakes the Node if it is waiting in begin
+     */
+    void wake();
+    /**
+     * @brief Updates the Devices on the calling thread, sending a publish request for each Device that is ready to publish.
+     *
+     * @param executeTime
+     * @return int32_t the minimum time before any Device needs to Publish again.
+     */
+    int32_t executeDevices(int32_t executeTime);
+    /**
+     * @brief Encodes the data payload of a Publishable without a sequence number.
+     *
+     * @param publishable The Publishable being encoded
+     * @param buffer The buffer the payload is encoded into, cleared if the payload fails to encode
+     * @return ssize_t The size of the encoded payload, or a negative value if the payload failed to encode
+     */
+    static ssize_t encodePublishable(Publishable *publishable, vector<uint8_t> &buffer);
     /**
      * @brief Publish a Birth message the node and all devices
      */
@@ -207,12 +436,18 @@ private:
      * @param payloadLength The length of the payload
      * @return int
      */
-    int onMessage(SparkplugClient *client, const std::string &topic, const void *payload, const int payloadLength);
+    int onMessage(SparkplugClient *client, std::string_view topic, const void *payload, const int payloadLength);
     /**
      * @brief Processes all events that were received and queued from onEvent.
      * This function is thread safe.
      */
     void processEvents();
+    /**
+     * @brief Handles a single event that was queued from onEvent.
+     *
+     * @param eventData The queued event
+     */
+    void processEvent(ClientEventData &eventData);
 
 protected:
 public:
@@ -246,7 +481,9 @@ public:
      */
     int enable();
     /**
-     * @brief TODO: Better Name
+     * @brief Runs the Node until it is stopped. Each Publishable has a publish timer on a timer wheel, and only
+     * Publishables whose timers have expired are updated. Between publishes the Node sleeps until the next timer is due,
+     * or until it is woken by a client event or a publish request. Devices must be added before the Node begins.
      *
      */
     void begin();
@@ -258,6 +495,41 @@ public:
      * @return int32_t the minimum time before any Publishable needs to Publish again.
      */
     int32_t execute(int32_t executeTime);
+#ifdef _GLIBCXX_HAS_GTHREADS
+    /**
+     * @brief Sets the number of worker threads used to update and encode Devices. Devices are split into shards
+     * which are processed in parallel by the workers and the thread calling execute or begin. With begin only the Devices whose publish timers
+     * have expired are processed. Must not be called while the Node is executing.
+     *
+     * @param count The number of worker threads, 0 updates and encodes all Devices on the thread calling execute
+     */
+    void setWorkerThreads(size_t count);
+#endif
+#ifdef CPP_SPARKPLUG_SPOOL
+    /**
+     * @brief Enables store and forward. While the Node has no active client, data that would have been published
+     * is written to a disk backed spool. Once a client becomes active and the Node has been reborn, the spooled data is
+     * replayed as historical metrics. Data left in the spool from a previous run is also replayed.
+     *
+     * @param directory The directory the spool is stored in
+     * @param maxBytes The maximum size of the spool. The oldest data is dropped once the spool is full.
+     * @return int 0 on success, -1 if the spool could not be opened
+     */
+    int enableSpool(const char *directory, size_t maxBytes);
+#endif
+    /**
+     * @brief Adds metrics to the Node that report the publish statistics of the active client and the Node.
+     * The metrics are sampled whenever the Node is due to publish. Must be called before the Node is enabled.
+     *
+     */
+    void enableStatisticsMetrics();
+    /**
+     * @brief Get the execution statistics of the Node. Statistics can be read from any thread.
+     * Publish statistics are kept by each client, see SparkplugClient::getStatistics.
+     *
+     * @return NodeStatistics&
+     */
+    NodeStatistics &getStatistics();
     /**
      * @brief Syncs all the clients on the node
      *
@@ -285,7 +557,7 @@ public:
     bool isActive();
 
     /**
-     * @brief Stops the node
+     * @brief Stops the node, and wakes the Node if it is running with begin so that it returns
      *
      */
     void stop();
@@ -309,6 +581,13 @@ public:
      * @param data Optional data that accompanies the event.
      */
     void onEvent(SparkplugClient *client, EventType eventType, void *data);
+    /**
+     * @brief Called by the Node and its Devices when the first of their metrics becomes dirty.
+     * When running with begin the Publishable is rescheduled and the Node is woken, otherwise this does nothing.
+     *
+     * @param publishable The Publishable with dirty metrics
+     */
+    void onPublishableDirty(Publishable *publishable) override;
 
     /**
      * @brief Is a Node
@@ -319,7 +598,10 @@ public:
 
     using Publishable::addMetric;
     using Publishable::addMetrics;
+    using Publishable::updateMetrics;
     using Publishable::addToPayload;
+    using Publishable::encodeBirth;
+    using Publishable::encodeData;
     using Publishable::canPublish;
     using Publishable::getName;
     using Publishable::update;
@@ -30,7 +30,12 @@
  */
 
 #include "Publishable.h"
+#include "utils/Protobuf.h"
+#ifdef CPP_SPARKPLUG_COMPRESSION
+#include "utils/Compression.h"
+#endif
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 
 #ifdef DEBUGGING
@@ -43,8 +48,21 @@
 
 using namespace std;
 
+/**
+ * @brief Source of metric aliases. Aliases only need to be unique within an Edge Node, using a single
+ * counter keeps them unique between a Node and all of its Devices. Starts at 1 as 0 marks a metric without an alias.
+ */
+static std::atomic<uint64_t> nextAlias(1);
+
 Publishable::~Publishable()
 {
+    // Metrics are shared, make sure they no longer reference this Publishable
+    for (auto &metric : metrics)
+    {
+        metric->setOwner(NULL);
+        metric->setNextDirty(NULL);
+    }
+
     if (this->name != NULL)
     {
         free(this->name);
@@ -64,6 +82,21 @@ Publishable::Publishable(const char *name, int publishPeriod) : publishPeriod(pu
 
 void Publishable::addMetric(const std::shared_ptr<Metric> &metric)
 {
+    if (metric->getAlias() == 0)
+    {
+        metric->setAlias(nextAlias++);
+    }
+    if (metric->getName() != NULL)
+    {
+        metricsByName[metric->getName()] = metric.get();
+    }
+    metricsByAlias[metric->getAlias()] = metric.get();
+    metric->setOwner(this);
+    MetricLock lock(this);
+    if (metric->isDirty())
+    {
+        onMetricDirty(metric.get());
+    }
     metrics.push_front(std::move(metric));
 }
 
@@ -77,10 +110,13 @@ void Publishable::addMetrics(const std::vector<std::shared_ptr<Metric>> &metrics
 
 int32_t Publishable::update(int32_t elapsed)
 {
+    MetricLock lock(this);
+    int32_t nextHeld = releaseHeldMetrics();
+
     PublishableState state = getState();
     if (state == PUBLISHING || state == CAN_PUBLISH)
     {
-        return publishPeriod;
+        return min(publishPeriod, nextHeld);
     }
 
     nextPublish -= elapsed;
@@ -91,7 +127,36 @@ int32_t Publishable::update(int32_t elapsed)
         nextPublish = publishPeriod;
     }
 
-    return nextPublish;
+    return min(nextPublish, nextHeld);
+}
+
+int32_t Publishable::releaseHeldMetrics()
+{
+    int32_t nextHeld = INT32_MAX;
+
+    if (heldMetrics.empty())
+    {
+        return nextHeld;
+    }
+
+    time_t now = TimeManager::getTime();
+
+    for (size_t i = 0; i < heldMetrics.size();)
+    {
+        int32_t remaining = heldMetrics[i]->checkHeld(now);
+
+        if (remaining > 0)
+        {
+            nextHeld = min(remaining, nextHeld);
+            i++;
+            continue;
+        }
+
+        heldMetrics[i] = heldMetrics.back();
+        heldMetrics.pop_back();
+    }
+
+    return nextHeld;
 }
 
 void Publishable::setPublishPeriod(int32_t publishPeriod)
@@ -112,9 +177,45 @@ void Publishable::setState(PublishableState state)
 
 void Publishable::published()
 {
+    MetricLock lock(this);
     setState(IDLE);
-    std::for_each(metrics.begin(), metrics.end(), [](std::shared_ptr<Metric> &metric)
-                  { metric->published(); });
+
+    if (birthPending)
+    {
+        // Births include every metric, so every metric has been published
+        birthPending = false;
+        std::for_each(metrics.begin(), metrics.end(), [](std::shared_ptr<Metric> &metric)
+                      { metric->published(); });
+    }
+
+    Metric *metric = dirtyMetrics;
+    dirtyMetrics = NULL;
+
+    while (metric != NULL)
+    {
+        Metric *next = metric->getNextDirty();
+        metric->setNextDirty(NULL);
+        metric->published();
+        metric = next;
+    }
+}
+
+void Publishable::onMetricHeld(Metric *metric)
+{
+    heldMetrics.push_back(metric);
+}
+
+void Publishable::onMetricDirty(Metric *metric)
+{
+    bool first = dirtyMetrics == NULL;
+
+    metric->setNextDirty(dirtyMetrics);
+    dirtyMetrics = metric;
+
+    if (first && owner != NULL)
+    {
+        owner->onPublishableDirty(this);
+    }
 }
 
 void Publishable::publishing()
@@ -124,9 +225,156 @@ void Publishable::publishing()
 
 void Publishable::addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBirth)
 {
+    MetricLock lock(this);
     nextPublish = publishPeriod;
-    for_each(metrics.begin(), metrics.end(), [payload, isBirth](std::shared_ptr<Metric> &metric)
-             { metric->addToPayload(payload, isBirth); });
+
+    if (isBirth)
+    {
+        birthPending = true;
+        for_each(metrics.begin(), metrics.end(), [payload](std::shared_ptr<Metric> &metric)
+                 { metric->addToPayload(payload, true); });
+        return;
+    }
+
+    for (Metric *metric = dirtyMetrics; metric != NULL; metric = metric->getNextDirty())
+    {
+        metric->addToPayload(payload, false);
+    }
+}
+
+int Publishable::encodeBirth(std::vector<uint8_t> &buffer, uint64_t timestamp)
+{
+    MetricLock lock(this);
+    nextPublish = publishPeriod;
+    birthPending = true;
+
+    buffer.clear();
+    buffer.push_back(PAYLOAD_TIMESTAMP_KEY);
+    appendProtobufVarint(buffer, timestamp);
+
+    for (auto &metric : metrics)
+    {
+        if (metric->appendBirth(buffer, timestamp) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int Publishable::nameEncodedData(const uint8_t *payload, size_t length, std::vector<uint8_t> &buffer)
+{
+    buffer.clear();
+
+    org_eclipse_tahu_protobuf_Payload decoded;
+    if (decode_payload(&decoded, payload, length) < 0)
+    {
+        free_payload(&decoded);
+        return -1;
+    }
+
+    for (pb_size_t i = 0; i < decoded.metrics_count; i++)
+    {
+        org_eclipse_tahu_protobuf_Payload_Metric *metric = &decoded.metrics[i];
+
+        if (metric->name == NULL && metric->has_alias)
+        {
+            Metric *named = findMetric(std::string_view(), true, metric->alias);
+
+            if (named == NULL)
+            {
+                LOGGER("No metric with alias %llu\n", (unsigned long long)metric->alias);
+                continue;
+            }
+            metric->name = strdup(named->getName());
+        }
+
+        if (metric->name != NULL)
+        {
+            metric->has_alias = false;
+            metric->alias = 0;
+        }
+    }
+
+    ssize_t encodedLength = encode_payload(NULL, 0, &decoded);
+
+    if (encodedLength > 0)
+    {
+        buffer.resize(encodedLength);
+        encodedLength = encode_payload(buffer.data(), buffer.size(), &decoded);
+    }
+
+    free_payload(&decoded);
+
+    if (encodedLength <= 0)
+    {
+        buffer.clear();
+        return -1;
+    }
+    return 0;
+}
+
+int Publishable::encodeData(std::vector<uint8_t> &buffer, uint64_t timestamp)
+{
+    buffer.clear();
+
+    if (!isStreamable())
+    {
+        org_eclipse_tahu_protobuf_Payload payload;
+        memset(&payload, 0, sizeof(payload));
+        payload.has_timestamp = true;
+        payload.timestamp = timestamp;
+
+        addToPayload(&payload, false);
+
+        size_t length = 0;
+        bool encoded = pb_get_encoded_size(&length, org_eclipse_tahu_protobuf_Payload_fields, &payload);
+
+        if (encoded)
+        {
+            buffer.resize(length);
+            pb_ostream_t stream = pb_ostream_from_buffer(buffer.data(), length);
+            encoded = pb_encode(&stream, org_eclipse_tahu_protobuf_Payload_fields, &payload);
+        }
+
+        free_payload(&payload);
+
+        if (!encoded)
+        {
+            buffer.clear();
+            return -1;
+        }
+        return 0;
+    }
+
+    MetricLock lock(this);
+    nextPublish = publishPeriod;
+
+    pb_ostream_t stream = protobufStreamFromVector(buffer);
+
+    if (!pb_encode_tag(&stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_timestamp_tag) ||
+        !pb_encode_varint(&stream, timestamp))
+    {
+        buffer.clear();
+        return -1;
+    }
+
+    for (Metric *metric = dirtyMetrics; metric != NULL; metric = metric->getNextDirty())
+    {
+        if (metric->encode(&stream, false) != 0)
+        {
+            buffer.clear();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+bool Publishable::isStreamable()
+{
+    return true;
 }
 
 bool Publishable::canPublish()
@@ -135,8 +383,9 @@ bool Publishable::canPublish()
     {
         return false;
     }
-    return any_of(metrics.begin(), metrics.end(), [](std::shared_ptr<Metric> &metric)
-                  { return metric->isDirty(); });
+
+    MetricLock lock(this);
+    return dirtyMetrics != NULL;
 }
 
 const char *Publishable::getName()
@@ -144,33 +393,337 @@ const char *Publishable::getName()
     return name;
 }
 
-void Publishable::handleCommand(__attribute__((unused)) Publisher *publisher, const void *payload, const int payloadLength)
+void Publishable::setOwner(PublishableOwner *owner)
+{
+    this->owner = owner;
+}
+
+void Publishable::setTopics(const std::string &birthTopic, const std::string &dataTopic)
+{
+    this->birthTopic = birthTopic;
+    this->dataTopic = dataTopic;
+}
+
+const std::string &Publishable::getTopic(bool isBirth)
+{
+    return isBirth ? birthTopic : dataTopic;
+}
+
+Metric *Publishable::findMetric(std::string_view name, bool hasAlias, uint64_t alias)
 {
-    // Decode the payload
-    org_eclipse_tahu_protobuf_Payload sparkplugPayload;
-    if (decode_payload(&sparkplugPayload, (uint8_t *)payload, payloadLength) < 0)
+    if (name.data() != NULL)
     {
-        free_payload(&sparkplugPayload);
-        return;
+        auto result = metricsByName.find(name);
+        return result != metricsByName.end() ? result->second : NULL;
     }
 
-    for (int i = sparkplugPayload.metrics_count - 1; i >= 0; i--)
+    // Commands can address a metric by its alias alone
+    if (hasAlias)
     {
-        org_eclipse_tahu_protobuf_Payload_Metric metricPayload = sparkplugPayload.metrics[i];
-        char *name = metricPayload.name;
-        forward_list<std::shared_ptr<Metric>>::iterator result;
+        auto result = metricsByAlias.find(alias);
+        return result != metricsByAlias.end() ? result->second : NULL;
+    }
 
-        result = find_if(metrics.begin(), metrics.end(), [name](std::shared_ptr<Metric> &metric)
-                         { return (strcmp(metric->getName(), name) == 0); });
+    return NULL;
+}
 
-        if (result != metrics.end())
+/**
+ * @brief Gets the wire type of a command metric field that can be read in place
+ *
+ * @param field The field number
+ * @return int The wire type, or -1 if the field can only be read by decoding the metric with nanopb
+ */
+static int getInPlaceWireType(uint32_t field)
+{
+    switch (field)
+    {
+    case org_eclipse_tahu_protobuf_Payload_Metric_name_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_string_value_tag:
+        return PROTOBUF_WIRE_LENGTH;
+    case org_eclipse_tahu_protobuf_Payload_Metric_float_value_tag:
+        return PROTOBUF_WIRE_FIXED32;
+    case org_eclipse_tahu_protobuf_Payload_Metric_double_value_tag:
+        return PROTOBUF_WIRE_FIXED64;
+    case org_eclipse_tahu_protobuf_Payload_Metric_alias_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_timestamp_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_datatype_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_is_historical_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_is_transient_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_is_null_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_long_value_tag:
+    case org_eclipse_tahu_protobuf_Payload_Metric_boolean_value_tag:
+        return PROTOBUF_WIRE_VARINT;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Reads an encoded command metric in place. Its scalar fields are stored in metricPayload, while its name and
+ * string value are returned as views into the encoded metric, so nothing is allocated.
+ *
+ * @param metricPayload Zeroed metric that receives the scalar fields, its name and string value are left unset
+ * @param name The name of the metric, a view without data if the metric has no name
+ * @param stringValue The string value of the metric
+ * @param isInPlace Set false if the metric carries fields that can only be read by decoding it with nanopb
+ * @return true if the metric could be read
+ */
+static bool readCommandMetric(const uint8_t *data, size_t length, org_eclipse_tahu_protobuf_Payload_Metric &metricPayload,
+                              std::string_view &name, std::string_view &stringValue, bool &isInPlace)
+{
+    ProtobufReader reader(data, length);
+    isInPlace = true;
+
+    while (!reader.isAtEnd())
+    {
+        uint32_t field;
+        uint8_t wireType;
+        const uint8_t *value;
+        size_t valueLength;
+        uint64_t number;
+
+        if (!reader.readKey(field, wireType))
         {
-            std::shared_ptr<Metric> metric;
-            metric = *result;
+            return false;
+        }
+
+        // Metadata, properties, bytes, datasets, templates and extensions are left to nanopb
+        if (getInPlaceWireType(field) != wireType)
+        {
+            isInPlace = false;
+            if (!reader.skip(wireType))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (wireType == PROTOBUF_WIRE_LENGTH)
+        {
+            if (!reader.readLengthDelimited(value, valueLength))
+            {
+                return false;
+            }
+            if (field == org_eclipse_tahu_protobuf_Payload_Metric_name_tag)
+            {
+                name = std::string_view((const char *)value, valueLength);
+            }
+            else
+            {
+                metricPayload.which_value = field;
+                stringValue = std::string_view((const char *)value, valueLength);
+            }
+            continue;
+        }
+
+        if (wireType != PROTOBUF_WIRE_VARINT)
+        {
+            if (!reader.readFixed(number, wireType == PROTOBUF_WIRE_FIXED32 ? 4 : 8))
+            {
+                return false;
+            }
+
+            metricPayload.which_value = field;
+            if (wireType == PROTOBUF_WIRE_FIXED32)
+            {
+                uint32_t bits = (uint32_t)number;
+                memcpy(&metricPayload.value.float_value, &bits, sizeof(bits));
+            }
+            else
+            {
+                memcpy(&metricPayload.value.double_value, &number, sizeof(number));
+            }
+            continue;
+        }
+
+        if (!reader.readVarint(number))
+        {
+            return false;
+        }
+
+        switch (field)
+        {
+        case org_eclipse_tahu_protobuf_Payload_Metric_alias_tag:
+            metricPayload.has_alias = true;
+            metricPayload.alias = number;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_timestamp_tag:
+            metricPayload.has_timestamp = true;
+            metricPayload.timestamp = number;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_datatype_tag:
+            metricPayload.has_datatype = true;
+            metricPayload.datatype = (uint32_t)number;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_is_historical_tag:
+            metricPayload.has_is_historical = true;
+            metricPayload.is_historical = number != 0;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_is_transient_tag:
+            metricPayload.has_is_transient = true;
+            metricPayload.is_transient = number != 0;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_is_null_tag:
+            metricPayload.has_is_null = true;
+            metricPayload.is_null = number != 0;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag:
+            metricPayload.which_value = field;
+            metricPayload.value.int_value = (uint32_t)number;
+            break;
+        case org_eclipse_tahu_protobuf_Payload_Metric_long_value_tag:
+            metricPayload.which_value = field;
+            metricPayload.value.long_value = number;
+            break;
+        default:
+            metricPayload.which_value = field;
+            metricPayload.value.boolean_value = number != 0;
+            break;
+        }
+    }
+
+    return true;
+}
+
+int Publishable::dispatchCommand(const uint8_t *payload, size_t length, __attribute__((unused)) bool allowEnvelope)
+{
+    ProtobufReader reader(payload, length);
+    commands.clear();
+#ifdef CPP_SPARKPLUG_COMPRESSION
+    std::string_view uuid;
+    std::string_view algorithm;
+    const uint8_t *body = NULL;
+    size_t bodyLength = 0;
+#endif
+
+    while (!reader.isAtEnd())
+    {
+        uint32_t field;
+        uint8_t wireType;
+
+        if (!reader.readKey(field, wireType))
+        {
+            return -1;
+        }
+
+        if (field == org_eclipse_tahu_protobuf_Payload_metrics_tag && wireType == PROTOBUF_WIRE_LENGTH)
+        {
+            CommandMetric command = {NULL, NULL, 0};
+            org_eclipse_tahu_protobuf_Payload_Metric metricPayload;
+            std::string_view name;
+            std::string_view stringValue;
+            bool isInPlace;
+
+            memset(&metricPayload, 0, sizeof(metricPayload));
+            if (!reader.readLengthDelimited(command.data, command.length) ||
+                !readCommandMetric(command.data, command.length, metricPayload, name, stringValue, isInPlace))
+            {
+                return -1;
+            }
+
+            // Metrics are resolved as they are read, so only those addressing one of our metrics are kept
+            command.metric = findMetric(name, metricPayload.has_alias, metricPayload.alias);
+            if (command.metric != NULL)
+            {
+                commands.push_back(command);
+            }
+
+#ifdef CPP_SPARKPLUG_COMPRESSION
+            if (name == SPARKPLUG_COMPRESSION_ALGORITHM_METRIC)
+            {
+                algorithm = stringValue;
+            }
+#endif
+        }
+#ifdef CPP_SPARKPLUG_COMPRESSION
+        else if (field == org_eclipse_tahu_protobuf_Payload_uuid_tag && wireType == PROTOBUF_WIRE_LENGTH)
+        {
+            const uint8_t *value;
+            size_t valueLength;
+
+            if (!reader.readLengthDelimited(value, valueLength))
+            {
+                return -1;
+            }
+            uuid = std::string_view((const char *)value, valueLength);
+        }
+        else if (field == org_eclipse_tahu_protobuf_Payload_body_tag && wireType == PROTOBUF_WIRE_LENGTH)
+        {
+            if (!reader.readLengthDelimited(body, bodyLength))
+            {
+                return -1;
+            }
+        }
+#endif
+        else if (!reader.skip(wireType))
+        {
+            return -1;
+        }
+    }
+
+#ifdef CPP_SPARKPLUG_COMPRESSION
+    // Commands may be sent as a compressed payload envelope, whose body holds the payload
+    if (allowEnvelope && uuid == SPARKPLUG_COMPRESSED_UUID)
+    {
+        std::vector<uint8_t> decompressed;
+
+        if (body == NULL || decompressBody(algorithm, body, bodyLength, decompressed) != 0)
+        {
+            return -1;
+        }
+        return dispatchCommand(decompressed.data(), decompressed.size(), false);
+    }
+#endif
+
+    for (auto command = commands.rbegin(); command != commands.rend(); command++)
+    {
+        org_eclipse_tahu_protobuf_Payload_Metric metricPayload;
+        std::string_view name;
+        std::string_view stringValue;
+        bool isInPlace;
+
+        memset(&metricPayload, 0, sizeof(metricPayload));
+        readCommandMetric(command->data, command->length, metricPayload, name, stringValue, isInPlace);
+
+        if (isInPlace)
+        {
+            // A named command was resolved by its name, so the metric's own name is the same string
+            metricPayload.name = name.data() != NULL ? (char *)command->metric->getName() : NULL;
+            if (metricPayload.which_value == org_eclipse_tahu_protobuf_Payload_Metric_string_value_tag)
+            {
+                commandString.assign(stringValue);
+                metricPayload.value.string_value = commandString.data();
+            }
+
             // Handle Device Command
-            metric->onCommand(&metricPayload);
+            command->metric->onCommand(&metricPayload);
+            continue;
         }
+
+        pb_istream_t stream = pb_istream_from_buffer(command->data, command->length);
+
+        memset(&metricPayload, 0, sizeof(metricPayload));
+        if (pb_decode(&stream, org_eclipse_tahu_protobuf_Payload_Metric_fields, &metricPayload))
+        {
+            command->metric->onCommand(&metricPayload);
+        }
+
+        pb_release(org_eclipse_tahu_protobuf_Payload_Metric_fields, &metricPayload);
     }
 
-    free_payload(&sparkplugPayload);
+    return 0;
+}
+
+void Publishable::handleCommand(__attribute__((unused)) Publisher *publisher, const void *payload, const int payloadLength)
+{
+    if (payload == NULL || payloadLength < 0)
+    {
+        return;
+    }
+
+    if (dispatchCommand((const uint8_t *)payload, payloadLength, true) != 0)
+    {
+        LOGGER("Failed to read command payload\n");
+    }
 }
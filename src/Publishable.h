@@ -33,15 +33,29 @@
 #define SRC_PUBLISHABLE
 
 #include "metrics/Metric.h"
+#include "metrics/simple/SimpleMetric.h"
 #include "CommonTypes.h"
 #include "Publisher.h"
 #include <tahu.h>
 #include <forward_list>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
 
 using namespace std;
 
 class Publisher;
+class Publishable;
+
+/**
+ * @brief Class for handling when a Publishable has metrics waiting to be published.
+ *
+ */
+class PublishableOwner
+{
+public:
+    virtual void onPublishableDirty(Publishable *publishable) = 0;
+};
 
 /**
  * @brief An enum of all Publishable States
@@ -59,29 +73,79 @@ enum PublishableState
  * This Class contains a set of Metrics and a configured Publish period that
  * determines the minimum time per publish.
  */
-class Publishable
+class Publishable : public MetricOwner
 {
 private:
+    /**
+     * @brief A metric of a command payload, located within the encoded payload along with the metric it addresses
+     */
+    typedef struct
+    {
+        Metric *metric;
+        const uint8_t *data;
+        size_t length;
+    } CommandMetric;
+
     char *name = NULL;
     int32_t publishPeriod;
     int32_t nextPublish;
     PublishableState state = IDLE;
 
     forward_list<std::shared_ptr<Metric>> metrics;
+    unordered_map<std::string_view, Metric *> metricsByName;
+    unordered_map<uint64_t, Metric *> metricsByAlias;
+    // Guarded by the metrics lock, as metrics can be changed from another thread
+    Metric *dirtyMetrics = NULL;
+    vector<Metric *> heldMetrics;
+    PublishableOwner *owner = NULL;
+    bool birthPending = false;
+    std::string birthTopic;
+    std::string dataTopic;
+    // Reused by every command, so dispatching commands does not allocate once they have grown to size
+    vector<CommandMetric> commands;
+    std::string commandString;
 
     /**
-     * @brief Get the State
-     * Thread safe
-     * @return PublishableState
+     * @brief Finds a metric referenced by an incoming command, by name if present otherwise by alias.
+     *
+     * @param name The name of the metric, a view without data if the command has no name
+     * @param hasAlias If the command has an alias
+     * @param alias The alias of the metric
+     * @return The metric, or NULL if the Publishable has no matching metric
      */
-    PublishableState getState();
+    Metric *findMetric(std::string_view name, bool hasAlias, uint64_t alias);
+    /**
+     * @brief Dispatches the metrics of an encoded command payload to the metrics they address.
+     * The payload is read in a single pass, and only the metrics that address one of the Publishable's metrics are dispatched.
+     * Metrics with scalar and string values are read in place, only those with nested messages or bytes are decoded by nanopb.
+     *
+     * @param payload The encoded payload
+     * @param length The length of the payload
+     * @param allowEnvelope If the payload may be a compressed payload envelope
+     * @return int 0 on success, -1 if the payload could not be read
+     */
+    int dispatchCommand(const uint8_t *payload, size_t length, bool allowEnvelope);
+
     /**
      * @brief Set the State
      * Thread safe
      */
     void setState(PublishableState);
+    /**
+     * @brief Checks the metrics that are holding back a change, marking the changes dirty once they can be published.
+     * Must be called while the metrics lock is held.
+     *
+     * @return int32_t the time before a held metric needs to be checked again, INT32_MAX if no metrics are held
+     */
+    int32_t releaseHeldMetrics();
 
 protected:
+    /**
+     * @brief Get the State
+     * Thread safe
+     * @return PublishableState
+     */
+    PublishableState getState();
     /**
      * @brief Set the Publish Period
      *
@@ -104,16 +168,56 @@ public:
     Publishable(const char *name, int publishPeriod);
     /**
      * @brief Set the Metrics on the Publishable
+     * Metrics without an alias are assigned one that is unique within the Edge Node.
      *
      * @param metrics An array of Metrics that will be handled by this Publishable
      * @param metricCount The number of Metrics being added
      */
     void addMetric(const std::shared_ptr<Metric> &metric);
     void addMetrics(const std::vector<std::shared_ptr<Metric>> &metrics);
+    /**
+     * @brief Sets the values of many metrics of the same type at once. The clock is read once and shared by every change,
+     * rather than once per changed metric. Each value is compared with the stored one and stored under a single hold of
+     * the metrics lock, so the whole batch is published together and the lock is not taken once per metric.
+     * The metrics must belong to this Publishable, otherwise no values are stored.
+     *
+     * @tparam T The type of the metrics
+     * @param updates An array of metrics and their new values
+     * @param count The number of updates
+     * @return int The number of metrics whose value was stored, or -1 if a metric is NULL or does not belong to this Publishable
+     */
+    template <typename T>
+    int updateMetrics(const MetricUpdate<T> *updates, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (updates[i].metric == NULL || updates[i].metric->getOwner() != (MetricOwner *)this)
+            {
+                return -1;
+            }
+        }
+
+        time_t time = TimeManager::getTime();
+        int changed = 0;
+        MetricLock lock(this);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            changed += updates[i].metric->setValueLocked(updates[i].value, time);
+        }
+
+        return changed;
+    };
+    template <typename T>
+    int updateMetrics(const std::vector<MetricUpdate<T>> &updates)
+    {
+        return updateMetrics(updates.data(), updates.size());
+    };
     /**
      * @brief Used to update the publishing timer for the Publishable. The amount of time supplied will be deducted from the remaining time before
      * the next publish. If more time has passed than the publish period then the Publishable will be marked as able to publish. The value returned
      * will be the remaining time before the next publish. If the Publishable is able to publish it will then return its publish period.
+     * Metrics holding back a change until their minimum interval has passed are released, and shorten the time returned.
      *
      * @param elapsed The amount of time to deduct from the remaining publishing time.
      * @return int32_t
@@ -140,13 +244,72 @@ public:
      * @param payload A protobuf payload that the Metrics will be added to
      * @param isBirth If the payload is a part of a birth message
      */
-    void addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBirth = false);
+    virtual void addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBirth = false);
+    /**
+     * @brief Encodes a birth payload of the Publishable, without a sequence number.
+     * Metrics with the birth cache enabled keep their encoding between births, and are only encoded again once they have changed.
+     * All other metrics are encoded for every birth.
+     *
+     * @param buffer The buffer the payload is encoded into, replacing its contents
+     * @param timestamp The timestamp of the birth
+     * @return int 0 on success, -1 if a metric could not be encoded
+     */
+    int encodeBirth(std::vector<uint8_t> &buffer, uint64_t timestamp);
+    /**
+     * @brief Encodes a data payload of the Publishable's dirty metrics, without a sequence number.
+     * The metrics are written straight into the buffer without building the struct form of the payload,
+     * unless the Publishable builds its payloads through addToPayload.
+     *
+     * @param buffer The buffer the payload is encoded into, replacing its contents
+     * @param timestamp The timestamp of the payload
+     * @return int 0 on success, -1 if the payload could not be encoded
+     */
+    int encodeData(std::vector<uint8_t> &buffer, uint64_t timestamp);
+    /**
+     * @brief Encodes a data payload of the Publishable again with the name of every metric instead of its alias.
+     * Aliases are only assigned for the life of the process, so payloads kept past a restart must name their metrics.
+     *
+     * @param payload The encoded data payload, whose metrics may only carry their alias
+     * @param length The length of the payload
+     * @param buffer The buffer the named payload is encoded into, replacing its contents
+     * @return int 0 on success, -1 if the payload could not be decoded or encoded
+     */
+    int nameEncodedData(const uint8_t *payload, size_t length, std::vector<uint8_t> &buffer);
+    /**
+     * @brief Whether data payloads are streamed straight from the metrics. Publishables that override addToPayload
+     * to add to the struct form of the payload return false, so their payloads are built with addToPayload.
+     *
+     * @return true
+     * @return false
+     */
+    virtual bool isStreamable();
     /**
      * @brief Get the name of the Publishable
      *
      * @return const char*
      */
     const char *getName();
+    /**
+     * @brief Sets the topics the Publishable's birth and data messages are published on.
+     * Topics are built once when the Publishable is added to a Node rather than on every publish.
+     *
+     * @param birthTopic The BIRTH topic
+     * @param dataTopic The DATA topic
+     */
+    void setTopics(const std::string &birthTopic, const std::string &dataTopic);
+    /**
+     * @brief Sets the owner of the Publishable that will be notified when the first of its metrics becomes dirty after being published.
+     *
+     * @param owner
+     */
+    void setOwner(PublishableOwner *owner);
+    /**
+     * @brief Get the topic used to publish a message
+     *
+     * @param isBirth If the message is a birth message
+     * @return const std::string&
+     */
+    const std::string &getTopic(bool isBirth);
 
     /**
      * @brief Callback for when a command has been received for the publishable.
@@ -156,6 +319,22 @@ public:
      */
     void handleCommand(Publisher *publisher, const void *payload, const int payloadLength);
 
+    /**
+     * @brief Callback for when one of the Publishable's metrics becomes dirty.
+     * The metric is added to the list of metrics that will be included in the next data payload,
+     * and the owner is notified if it is the first dirty metric. Called while the metrics lock is held.
+     *
+     * @param metric
+     */
+    virtual void onMetricDirty(Metric *metric) override;
+    /**
+     * @brief Callback for when one of the Publishable's metrics holds back a change until it can be published.
+     * The metric is checked again on every update until the change has been released. Called while the metrics lock is held.
+     *
+     * @param metric
+     */
+    virtual void onMetricHeld(Metric *metric) override;
+
     /**
      * @brief Returns whether the Publishable instance is a Node.
      *
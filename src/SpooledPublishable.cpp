@@ -0,0 +1,71 @@
+/*
+ * File: SpooledPublishable.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "SpooledPublishable.h"
+
+void SpooledPublishable::setRecord(std::string_view topic, const uint8_t *payload, size_t length)
+{
+    record.assign(payload, payload + length);
+    setTopics(std::string(), std::string(topic));
+}
+
+void SpooledPublishable::addToPayload(org_eclipse_tahu_protobuf_Payload *payload, __attribute__((unused)) bool isBirth)
+{
+    org_eclipse_tahu_protobuf_Payload spooledPayload;
+    if (decode_payload(&spooledPayload, record.data(), record.size()) < 0)
+    {
+        free_payload(&spooledPayload);
+        return;
+    }
+
+    for (pb_size_t i = 0; i < spooledPayload.metrics_count; i++)
+    {
+        org_eclipse_tahu_protobuf_Payload_Metric *metric = &spooledPayload.metrics[i];
+        metric->has_is_historical = true;
+        metric->is_historical = true;
+
+        // Ownership of the metric's data moves to the outgoing payload
+        add_metric_to_payload(payload, metric);
+    }
+
+    spooledPayload.metrics_count = 0;
+    free_payload(&spooledPayload);
+}
+
+bool SpooledPublishable::isStreamable()
+{
+    return false;
+}
+
+bool SpooledPublishable::isNode()
+{
+    return false;
+}
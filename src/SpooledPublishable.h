@@ -0,0 +1,74 @@
+/*
+ * File: SpooledPublishable.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_SPOOLEDPUBLISHABLE
+#define SRC_SPOOLEDPUBLISHABLE
+
+#include "Publishable.h"
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief A Publishable used to replay a payload that was spooled while the Node was offline.
+ * The metrics of the spooled payload are republished as historical metrics.
+ */
+class SpooledPublishable : public Publishable
+{
+private:
+    std::vector<uint8_t> record;
+
+public:
+    SpooledPublishable() : Publishable(){};
+    /**
+     * @brief Sets the spooled payload that will be replayed. The payload is copied.
+     *
+     * @param topic The topic the payload was originally published on
+     * @param payload The encoded payload
+     * @param length The length of the payload
+     */
+    void setRecord(std::string_view topic, const uint8_t *payload, size_t length);
+    /**
+     * @brief Adds the metrics of the spooled payload to a protobuf payload, flagged as historical
+     *
+     * @param payload A protobuf payload that the Metrics will be added to
+     * @param isBirth Unused, spooled payloads are never births
+     */
+    virtual void addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBirth = false) override;
+    /**
+     * @brief Spooled payloads are replayed from their decoded struct form
+     *
+     * @return false
+     */
+    virtual bool isStreamable() override;
+    virtual bool isNode() override;
+};
+
+#endif /* SRC_SPOOLEDPUBLISHABLE */
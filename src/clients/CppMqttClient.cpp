@@ -74,6 +74,8 @@ void CppMqttClient::dumpQueue()
         undelivered(publishQueue.front());
         publishQueue.pop();
     }
+
+    statistics.queueDepth.set(0);
 }
 
 void CppMqttClient::setPrimary(bool isPrimary)
@@ -249,9 +251,8 @@ int CppMqttClient::configureClient(ClientOptions *options)
 
     size_t size = getWillPayload(&buffer);
 
-    will->setBinaryPayload((const char *)buffer, size);
-
-    free(buffer);
+    willPayload.assign(buffer, buffer + size);
+    will->setBinaryPayload((const char *)willPayload.data(), willPayload.size());
 
     client.setWill(will);
 
@@ -279,6 +280,7 @@ bool CppMqttClient::isConnected()
 int CppMqttClient::request(PublishRequest *publishRequest)
 {
     publishQueue.push(publishRequest);
+    statistics.queueDepth.set(publishQueue.size());
     if (publishQueue.size() == 1 && isConnected())
     {
         publishFromQueue();
@@ -306,8 +308,7 @@ void CppMqttClient::onDisconnection(ReasonCode reasonCode)
 
 void CppMqttClient::onMessage(EncodedString &topic, Payload &payload)
 {
-    string strTopic(topic.data, topic.length);
-    messageReceived(strTopic, payload.getData(), payload.size());
+    messageReceived(std::string_view(topic.data, topic.length), payload.getData(), payload.size());
 }
 
 void CppMqttClient::onDeliveryComplete(Token token)
@@ -316,6 +317,7 @@ void CppMqttClient::onDeliveryComplete(Token token)
     if (publishRequest->token == token)
     {
         publishQueue.pop();
+        statistics.queueDepth.set(publishQueue.size());
         delivered(publishRequest);
         publishFromQueue();
     }
@@ -338,6 +340,7 @@ void CppMqttClient::onDeliveryFailure(Token token, __attribute__((unused)) int r
         if (publishRequest->retryCount >= PUBLISH_RETRIES || !isConnected())
         {
             publishQueue.pop();
+            statistics.queueDepth.set(publishQueue.size());
             undelivered(publishRequest);
             publishFromQueue();
         }
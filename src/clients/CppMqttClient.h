@@ -38,6 +38,7 @@
 #include "MqttClient.h"
 #include "Client.h"
 #include <memory>
+#include <vector>
 
 using namespace std;
 using namespace CppMqtt;
@@ -51,6 +52,10 @@ private:
 
     ClientOptions *options;
     WillProperties *will = nullptr;
+    /**
+     * @brief A copy of the will payload, as the encode buffer it is built in is reused by the client
+     */
+    vector<uint8_t> willPayload;
 
 protected:
     queue<PublishRequest *> publishQueue;
@@ -73,6 +73,19 @@ static int messageArrived(void *context, char *topicName, int topicLength, MQTTA
     return client->onMessage(topicName, topicLength, message);
 }
 
+/**
+ * @brief Frees a message that was received from the Paho Async Client
+ *
+ * @param message The Paho message
+ * @param topic The topic buffer of the message
+ */
+static void releaseMessage(void *message, char *topic)
+{
+    MQTTAsync_message *pahoMessage = (MQTTAsync_message *)message;
+    MQTTAsync_freeMessage(&pahoMessage);
+    MQTTAsync_free(topic);
+}
+
 /**
  * @brief
  *
@@ -276,7 +289,7 @@ int PahoAsyncClient::configureClient(ClientOptions *options)
     connectionOptions.onSuccess = connectionSuccess;
     connectionOptions.onFailure = connectionFailure;
 
-    connectionOptions.maxInflight = 10;
+    connectionOptions.maxInflight = maxInflight;
 
     connectionOptions.username = options->username;
     connectionOptions.password = options->password;
@@ -304,28 +317,16 @@ PahoAsyncClient::~PahoAsyncClient()
 
 int PahoAsyncClient::onMessage(char *topicName, int topicLength, MQTTAsync_message *message)
 {
-    {
-        std::string stringTopic(topicName, topicLength);
-        messageReceived(stringTopic, message->payload, message->payloadlen);
-    }
+    // A topic length of 0 denotes a null terminated topic
+    std::string_view topic(topicName, topicLength > 0 ? topicLength : strlen(topicName));
 
-    MQTTAsync_freeMessage(&message);
-    return 1;
-}
+    // Ownership of the message is passed on, it is freed once the event has been dispatched
+    MessageEventStruct messageEvent(
+        topic, message->payload, message->payloadlen,
+        message, topicName, releaseMessage);
+    messageReceived(messageEvent);
 
-void PahoAsyncClient::onDelivery(DeliveryToken token)
-{
-    PublishRequest *publishRequest = publishQueue.front();
-    if (publishRequest->token == token)
-    {
-        publishQueue.pop();
-        delivered(publishRequest);
-        publishFromQueue();
-    }
-    else
-    {
-        PAHOASYNCCLIENT_LOGGER "Oh no, we have a publish without a correct token\n";
-    }
+    return 1;
 }
 
 void PahoAsyncClient::onConnect()
@@ -344,6 +345,11 @@ void PahoAsyncClient::onCommandSubscription()
     activated();
 }
 
+void PahoAsyncClient::sync()
+{
+    publishFromQueue();
+}
+
 bool PahoAsyncClient::isConnected()
 {
     return MQTTAsync_isConnected(client);
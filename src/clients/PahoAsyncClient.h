@@ -111,15 +111,6 @@ public:
      */
     PahoAsyncClient(ClientEventHandler *handler, ClientOptions *options) : PahoClient(handler, options) {}
     virtual ~PahoAsyncClient();
-    /**
-     * @brief Callback method for when a publish has been delivered on a client.
-     * The token is used to match to a SparkplugRequest. The client will inform the EventHandler of the
-     * delivered message and then free the memory used by the Request.
-     * Finally more requests will be published if the queue contains items
-     *
-     * @param token The unique token of the request
-     */
-    void onDelivery(DeliveryToken token);
     /**
      * @brief Callback method when the Client successfully connects to a MQTT Host. Will inform the EventHandler that the Client has connected.
      */
@@ -142,10 +133,10 @@ public:
     int onMessage(char *topicName, int topicLength, MQTTAsync_message *message);
     /**
      * @brief Used to synchronise the MQTT client.
-     * As the Paho Client is async this function does nothing.
+     * As the Paho Client is async this only sends failed requests whose retry delay has passed.
      *
      */
-    virtual void sync() override {};
+    virtual void sync() override;
     /**
      * @brief Callback for when Node/Device topics have successfully subscribed.
      */
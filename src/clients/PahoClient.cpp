@@ -40,6 +40,21 @@ using namespace std;
 
 #define PAHOCLIENT_LOGGER cout << "Paho Async Client: "
 
+#ifdef _GLIBCXX_HAS_GTHREADS
+#define QUEUE_LOCK() lock_guard<recursive_mutex> queueLock(queueMutex)
+#else
+#define QUEUE_LOCK()
+#endif
+
+PahoClient::PahoClient(ClientEventHandler *handler, ClientOptions *options) : SparkplugClient(handler, options)
+{
+    if (options != NULL && options->maxInflight > 0)
+    {
+        maxInflight = options->maxInflight;
+        inflight.resize(maxInflight);
+    }
+}
+
 PahoClient::~PahoClient()
 {
     dumpQueue();
@@ -55,62 +70,188 @@ void PahoClient::setPrimary(bool isPrimary)
     }
 }
 
-void PahoClient::publishFromQueue()
+void PahoClient::sendRequest(PublishRequest *publishRequest)
 {
-    if (!isConnected())
+    size_t slot = (inflightStart + inflightSpan) % maxInflight;
+
+    inflight[slot] = {publishRequest, false, false, 0};
+    inflightSpan++;
+    inflightCount++;
+
+    attemptSend(slot);
+}
+
+void PahoClient::attemptSend(size_t slot)
+{
+    if (processRequest(inflight[slot].request) == 0)
     {
+        inflight[slot].sent = true;
         return;
     }
-    //    MQTTAsync_isComplete
-    if (getPrimary() && publishQueue.size() > 0)
+
+    retryLater(slot);
+}
+
+void PahoClient::retryLater(size_t slot)
+{
+    InflightSlot &entry = inflight[slot];
+    PublishRequest *publishRequest = entry.request;
+
+    if (publishRequest->retryCount >= PUBLISH_RETRIES || !isConnected())
     {
-        processRequest(publishQueue.front());
+        releaseSlot(slot);
+        undelivered(publishRequest);
+        return;
     }
-    else
+
+    if (!entry.retried)
     {
-        if (getState() == PUBLISHING_PAYLOAD)
-        {
-            setState(CONNECTED);
-        }
+        entry.retried = true;
+        retrying++;
     }
+
+    entry.sent = false;
+    entry.retryTime = statisticsTime() + ((uint64_t)PUBLISH_RETRY_DELAY * 1000 << publishRequest->retryCount);
+    publishRequest->retryCount++;
 }
 
-void PahoClient::dumpQueue()
+void PahoClient::releaseSlot(size_t slot)
 {
-    while (!publishQueue.empty())
+    if (inflight[slot].retried)
     {
-        undelivered(publishQueue.front());
-        publishQueue.pop();
+        retrying--;
+    }
+
+    inflight[slot] = {NULL, false, false, 0};
+    inflightCount--;
+
+    while (inflightSpan > 0 && inflight[inflightStart].request == NULL)
+    {
+        inflightStart = (inflightStart + 1) % maxInflight;
+        inflightSpan--;
     }
 }
 
-void PahoClient::onDeliveryFailure(DeliveryToken token)
+size_t PahoClient::findSlot(DeliveryToken token)
 {
-    if (publishQueue.empty())
+    // Deliveries mostly arrive in the order requests were sent, so the search starts at the oldest slot
+    for (size_t i = 0; i < inflightSpan; i++)
     {
-        return;
+        size_t slot = (inflightStart + i) % maxInflight;
+
+        if (inflight[slot].request != NULL && inflight[slot].sent && inflight[slot].request->token == token)
+        {
+            return slot;
+        }
     }
+    return maxInflight;
+}
 
-    PublishRequest *publishRequest = publishQueue.front();
+void PahoClient::publishFromQueue()
+{
+    QUEUE_LOCK();
 
-    if (publishRequest->token == token)
+    if (!isConnected())
     {
-        if (publishRequest->retryCount >= PUBLISH_RETRIES || !isConnected())
+        return;
+    }
+
+    if (retrying > 0)
+    {
+        uint64_t now = statisticsTime();
+        size_t start = inflightStart;
+        size_t span = inflightSpan;
+
+        // Retries that are dropped release their slots, so the window is walked from where it started
+        for (size_t i = 0; i < span; i++)
         {
-            publishQueue.pop();
-            undelivered(publishRequest);
-            publishFromQueue();
+            size_t slot = (start + i) % maxInflight;
+
+            if (inflight[slot].request != NULL && !inflight[slot].sent && inflight[slot].retryTime <= now)
+            {
+                attemptSend(slot);
+            }
         }
-        else
+    }
+
+    // The window is held while a failed request is outstanding, so it is not overtaken by newer requests
+    while (getPrimary() && retrying == 0 && !publishQueue.empty() && inflightSpan < maxInflight)
+    {
+        PublishRequest *publishRequest = publishQueue.front();
+        publishQueue.pop_front();
+        sendRequest(publishRequest);
+    }
+
+    statistics.queueDepth.set(publishQueue.size());
+
+    if (publishQueue.empty() && inflightCount == 0 && getState() == PUBLISHING_PAYLOAD)
+    {
+        setState(CONNECTED);
+    }
+}
+
+void PahoClient::dumpQueue()
+{
+    QUEUE_LOCK();
+
+    for (size_t i = 0; i < inflightSpan; i++)
+    {
+        InflightSlot &slot = inflight[(inflightStart + i) % maxInflight];
+
+        if (slot.request != NULL)
         {
-            publishRequest->retryCount++;
-            processRequest(publishRequest);
+            undelivered(slot.request);
+            slot = {NULL, false, false, 0};
         }
     }
-    else
+    inflightStart = 0;
+    inflightSpan = 0;
+    inflightCount = 0;
+    retrying = 0;
+
+    while (!publishQueue.empty())
+    {
+        undelivered(publishQueue.front());
+        publishQueue.pop_front();
+    }
+
+    statistics.queueDepth.set(0);
+}
+
+void PahoClient::onDelivery(DeliveryToken token)
+{
+    QUEUE_LOCK();
+
+    size_t slot = findSlot(token);
+
+    if (slot == maxInflight)
     {
         PAHOCLIENT_LOGGER "Oh no, we have a publish without a correct token\n";
+        return;
     }
+
+    PublishRequest *publishRequest = inflight[slot].request;
+    releaseSlot(slot);
+    delivered(publishRequest);
+    publishFromQueue();
+}
+
+void PahoClient::onDeliveryFailure(DeliveryToken token)
+{
+    QUEUE_LOCK();
+
+    size_t slot = findSlot(token);
+
+    if (slot == maxInflight)
+    {
+        PAHOCLIENT_LOGGER "Oh no, we have a publish without a correct token\n";
+        return;
+    }
+
+    // The request keeps its slot and its sequence, and is sent again once the retry delay has passed
+    retryLater(slot);
+
+    publishFromQueue();
 }
 
 void PahoClient::onDisconnect(char *cause)
@@ -121,8 +262,14 @@ void PahoClient::onDisconnect(char *cause)
 
 int PahoClient::request(PublishRequest *publishRequest)
 {
-    publishQueue.push(publishRequest);
-    if (publishQueue.size() == 1 && isConnected())
+    // Encoding on the requesting thread keeps the delivery callbacks, which send from the queue, to stamping the sequence
+    prepareRequest(publishRequest);
+
+    QUEUE_LOCK();
+
+    publishQueue.push_back(publishRequest);
+    statistics.queueDepth.set(publishQueue.size());
+    if (isConnected())
     {
         publishFromQueue();
     }
@@ -34,16 +34,88 @@
 
 #include "clients/SparkplugClient.h"
 #include "CommonTypes.h"
-#include <queue>
+#include <deque>
+#include <vector>
+#include <mutex>
+
+#define DEFAULT_MAX_INFLIGHT 10
+
+/**
+ * @brief The time in milliseconds before a failed publish is retried, doubled with every further retry of the same request
+ */
+#ifndef PUBLISH_RETRY_DELAY
+#define PUBLISH_RETRY_DELAY 50
+#endif
 
 class PahoClient : public SparkplugClient
 {
 private:
+    /**
+     * @brief Takes the next slot of the in flight window for a PublishRequest and hands the request to the MQTT Client.
+     *
+     * @param publishRequest
+     */
+    void sendRequest(PublishRequest *publishRequest);
+    /**
+     * @brief Hands the request of an in flight slot to the MQTT Client. If the client rejects the publish
+     * the request is left in its slot to be retried later.
+     *
+     * @param slot
+     */
+    void attemptSend(size_t slot);
+    /**
+     * @brief Schedules the request of an in flight slot to be sent again once the retry delay has passed.
+     * Requests that have run out of retries, or fail while the Client is disconnected, are marked as undelivered.
+     *
+     * @param slot
+     */
+    void retryLater(size_t slot);
+    /**
+     * @brief Empties an in flight slot, moving the start of the window past any slots that are empty
+     *
+     * @param slot
+     */
+    void releaseSlot(size_t slot);
+    /**
+     * @brief Finds the in flight slot of a sent request
+     *
+     * @param token The delivery token of the request
+     * @return size_t The slot, or the size of the window if no sent request has the token
+     */
+    size_t findSlot(DeliveryToken token);
+
 protected:
-    queue<PublishRequest *> publishQueue;
     /**
-     * @brief Used to initiate a publish from the PublishRequest queue. If the queue is empty the Client will be set to a Connected State.
-     * If there are requests in the queue then the front item of the queue will be published and the Client will be set to a Publishing State.
+     * @brief A slot of the in flight window. A request stays in its slot until it is delivered or dropped,
+     * including while it waits to be retried.
+     */
+    typedef struct
+    {
+        PublishRequest *request;
+        bool sent;
+        bool retried;
+        uint64_t retryTime;
+    } InflightSlot;
+
+    deque<PublishRequest *> publishQueue;
+    size_t maxInflight = DEFAULT_MAX_INFLIGHT;
+    /**
+     * @brief The in flight window, a ring of maxInflight slots in the order requests were first sent
+     */
+    vector<InflightSlot> inflight = vector<InflightSlot>(DEFAULT_MAX_INFLIGHT);
+    size_t inflightStart = 0;
+    size_t inflightSpan = 0;
+    size_t inflightCount = 0;
+    size_t retrying = 0;
+#ifdef _GLIBCXX_HAS_GTHREADS
+    recursive_mutex queueMutex;
+#endif
+    /**
+     * @brief Used to initiate publishes from the PublishRequest queue. Failed requests whose retry delay has passed are sent again first.
+     * Requests are then taken from the front of the queue and published until the queue is empty or the in flight window is full.
+     * No new requests are published while a failed request is awaiting delivery, so only requests that were already in flight
+     * can reach the host ahead of it. If nothing is queued or in flight the Client will be set to a Connected State,
+     * otherwise it remains in a Publishing State.
      */
     void publishFromQueue();
     /**
@@ -69,13 +141,23 @@ public:
      * @param handler The Event Handler that manages the callbacks from the Client
      * @param options The options for configuring the MQTT Client
      */
-    PahoClient(ClientEventHandler *handler, ClientOptions *options) : SparkplugClient(handler, options) {}
+    PahoClient(ClientEventHandler *handler, ClientOptions *options);
     virtual ~PahoClient();
     /**
-     * @brief Callback method for when a publish failed delivery on the client.
-     * The Client will re-attempt to send the SparkplugRequest a few times before dumping the request.
+     * @brief Callback method for when a publish has been delivered on a client.
+     * The token is used to match to an in flight SparkplugRequest. The client will inform the EventHandler of the
+     * delivered message and then free the memory used by the Request.
      * Finally more requests will be published if the queue contains items
      *
+     * @param token The unique token of the request
+     */
+    void onDelivery(DeliveryToken token);
+    /**
+     * @brief Callback method for when a publish failed delivery on the client.
+     * The token is used to match to an in flight SparkplugRequest. The Client will re-attempt to send the SparkplugRequest
+     * a few times, backing off between attempts, before dumping the request.
+     * A retried request keeps the sequence number it was first sent with, and new requests are held back until it is delivered.
+     *
      * @param token The unique token of the failed request
      */
     void onDeliveryFailure(DeliveryToken token);
@@ -87,7 +169,7 @@ public:
     void onDisconnect(char *cause);
     /**
      * @brief Handles a request to publish data to the MQTT Host
-     * If requests are being published then the requests is added to the queue
+     * The request is added to the queue and published as soon as there is room in the in flight window
      *
      * @param publishRequest
      * @return int
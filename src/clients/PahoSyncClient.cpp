@@ -31,6 +31,7 @@
 
 #include "PahoSyncClient.h"
 #include <iostream>
+#include <vector>
 
 #define QOS 1
 
@@ -38,6 +39,19 @@ using namespace std;
 
 #define PAHOSYNCCLIENT_LOGGER cout << "Paho Client: "
 
+/**
+ * @brief Frees a message that was received from the Paho Client
+ *
+ * @param message The Paho message
+ * @param topic The topic buffer of the message
+ */
+static void releaseMessage(void *message, char *topic)
+{
+    MQTTClient_message *pahoMessage = (MQTTClient_message *)message;
+    MQTTClient_freeMessage(&pahoMessage);
+    MQTTClient_free(topic);
+}
+
 int PahoSyncClient::clientConnect()
 {
     if (getState() != DISCONNECTED)
@@ -135,16 +149,7 @@ int PahoSyncClient::unsubscribeToCommands()
 
 int PahoSyncClient::publishMessage(const std::string &topic, uint8_t *buffer, size_t length, DeliveryToken *token)
 {
-    int returnCode = MQTTClient_publish(client, topic.c_str(), length, buffer, QOS, 0, token);
-
-    if (returnCode == MQTTCLIENT_SUCCESS)
-    {
-    }
-    else
-    {
-        onDeliveryFailure(*token);
-    }
-    return returnCode;
+    return MQTTClient_publish(client, topic.c_str(), length, buffer, QOS, 0, token);
 }
 int PahoSyncClient::configureClient(ClientOptions *options)
 {
@@ -169,6 +174,9 @@ int PahoSyncClient::configureClient(ClientOptions *options)
     connectionOptions.keepAliveInterval = options->keepAliveInterval;
     connectionOptions.retryInterval = 0;
     connectionOptions.cleansession = 1;
+    // Allow multiple publishes to be in flight at once, the window is managed by the PahoClient
+    connectionOptions.reliable = 0;
+    connectionOptions.maxInflightMessages = maxInflight;
 
     will.qos = 0;
     will.retained = 0;
@@ -191,44 +199,6 @@ void PahoSyncClient::sync()
     char *topic;
     int topicLength = 0, result;
 
-    if (!publishQueue.empty())
-    {
-        PublishRequest *publishRequest = publishQueue.front();
-        result = MQTTClient_waitForCompletion(client, publishRequest->token, 1);
-        if (result == MQTTCLIENT_SUCCESS)
-        {
-            publishQueue.pop();
-            delivered(publishRequest);
-            publishFromQueue();
-        }
-        else if (result == MQTTCLIENT_DISCONNECTED)
-        {
-            onDisconnect(NULL);
-            return;
-        }
-
-        int *tokens;
-
-        result = MQTTClient_getPendingDeliveryTokens(client, &tokens);
-
-        if (tokens != NULL)
-        {
-            if (tokens[0] == -1)
-            {
-                // We have no inflight tokens, yet we have a publish queue.
-                // Enable publishing
-                publishFromQueue();
-            }
-
-            free(tokens);
-        }
-        else if (result == MQTTCLIENT_DISCONNECTED)
-        {
-            onDisconnect(NULL);
-            return;
-        }
-    }
-
     while (true)
     {
         result = MQTTClient_receive(client, &topic, &topicLength, &message, 0);
@@ -236,13 +206,14 @@ void PahoSyncClient::sync()
         {
             if (message != NULL)
             {
-                {
-                    std::string stringTopic(topic, topicLength);
-                    messageReceived(stringTopic, message->payload, message->payloadlen);
-                    MQTTClient_freeMessage(&message);
-                }
-
-                free(topic);
+                // A topic length of 0 denotes a null terminated topic
+                std::string_view topicView(topic, topicLength > 0 ? topicLength : strlen(topic));
+
+                // Ownership of the message is passed on, it is freed once the event has been dispatched
+                MessageEventStruct messageEvent(
+                    topicView, message->payload, message->payloadlen,
+                    message, topic, releaseMessage);
+                messageReceived(messageEvent);
             }
             else
             {
@@ -253,7 +224,7 @@ void PahoSyncClient::sync()
         else if (result == MQTTCLIENT_DISCONNECTED)
         {
             onDisconnect(NULL);
-            break;
+            return;
         }
         else
         {
@@ -261,6 +232,63 @@ void PahoSyncClient::sync()
             break;
         }
     }
+
+    if (inflightCount == 0 || retrying > 0)
+    {
+        // Publish anything that is waiting in the queue, and any failed request that is due to be retried
+        publishFromQueue();
+    }
+
+    if (inflightCount == 0)
+    {
+        return;
+    }
+
+    int *tokens = NULL;
+
+    result = MQTTClient_getPendingDeliveryTokens(client, &tokens);
+
+    if (result == MQTTCLIENT_DISCONNECTED)
+    {
+        onDisconnect(NULL);
+        return;
+    }
+
+    // Any inflight request that is no longer pending has been delivered
+    vector<DeliveryToken> completed;
+
+    for (auto &slot : inflight)
+    {
+        if (slot.request == NULL || !slot.sent)
+        {
+            continue;
+        }
+
+        bool pending = false;
+        for (int *token = tokens; token != NULL && *token != -1; token++)
+        {
+            if (*token == slot.request->token)
+            {
+                pending = true;
+                break;
+            }
+        }
+
+        if (!pending)
+        {
+            completed.push_back(slot.request->token);
+        }
+    }
+
+    if (tokens != NULL)
+    {
+        free(tokens);
+    }
+
+    for (DeliveryToken token : completed)
+    {
+        onDelivery(token);
+    }
 }
 
 bool PahoSyncClient::isConnected()
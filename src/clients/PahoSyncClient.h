@@ -111,15 +111,6 @@ public:
      */
     PahoSyncClient(ClientEventHandler *handler, ClientOptions *options) : PahoClient(handler, options) {}
     ~PahoSyncClient();
-    /**
-     * @brief Callback method for when a publish has been delivered on a client.
-     * The token is used to match to a SparkplugRequest. The client will inform the EventHandler of the
-     * delivered message and then free the memory used by the Request.
-     * Finally more requests will be published if the queue contains items
-     *
-     * @param token The unique token of the request
-     */
-    void onDelivery(DeliveryToken token);
     /**
      * @brief Callback method when the Client successfully connects to a MQTT Host. Will inform the EventHandler that the Client has connected.
      */
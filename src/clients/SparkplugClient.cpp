@@ -31,7 +31,10 @@
 
 #include "SparkplugClient.h"
 #include "utils/TimeManager.h"
+#include "utils/PublishRequestPool.h"
+#include "utils/Protobuf.h"
 #include "../metrics/simple/Int64Metric.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
@@ -56,6 +59,10 @@ SparkplugClient::SparkplugClient(ClientEventHandler *handler, ClientOptions *opt
 
 SparkplugClient::~SparkplugClient()
 {
+    if (encodeBuffer != NULL)
+    {
+        free(encodeBuffer);
+    }
 }
 
 int SparkplugClient::configure(ClientTopicOptions *topics)
@@ -138,7 +145,7 @@ size_t SparkplugClient::getWillPayload(uint8_t **buffer)
 
     auto bdSeqMetric = Int64Metric::create("bdSeq", bdSeq);
 
-    org_eclipse_tahu_protobuf_Payload *payload = initializePayload(false);
+    org_eclipse_tahu_protobuf_Payload *payload = initializePayload();
 
     bdSeqMetric->addToPayload(payload, true);
 
@@ -210,7 +217,7 @@ void SparkplugClient::resetSequence()
     payloadSequence = 0;
 }
 
-org_eclipse_tahu_protobuf_Payload *SparkplugClient::initializePayload(bool hasSeq)
+org_eclipse_tahu_protobuf_Payload *SparkplugClient::initializePayload()
 {
     org_eclipse_tahu_protobuf_Payload *payload = (org_eclipse_tahu_protobuf_Payload *)malloc(sizeof(org_eclipse_tahu_protobuf_Payload));
 
@@ -218,25 +225,154 @@ org_eclipse_tahu_protobuf_Payload *SparkplugClient::initializePayload(bool hasSe
     memset(payload, 0, sizeof(org_eclipse_tahu_protobuf_Payload));
     payload->has_timestamp = true;
     payload->timestamp = TimeManager::getTime();
-    if (hasSeq)
+    return payload;
+}
+
+bool SparkplugClient::reserveEncodeBuffer(size_t length)
+{
+    if (length <= encodeBufferLength)
     {
-        LOGGER("Current Sequence Number: %u\n", payloadSequence);
-        payload->seq = payloadSequence++;
-        payload->has_seq = true;
+        return true;
     }
-    return payload;
+
+    size_t newLength = encodeBufferLength > 0 ? encodeBufferLength : MAX_BUFFER_LENGTH;
+
+    while (newLength < length)
+    {
+        newLength *= 2;
+    }
+
+    uint8_t *newBuffer = (uint8_t *)realloc(encodeBuffer, newLength);
+
+    if (newBuffer == NULL)
+    {
+        LOGGER("Failed to grow the encode buffer to %zu bytes\n", newLength);
+        return false;
+    }
+
+    encodeBuffer = newBuffer;
+    encodeBufferLength = newLength;
+    return true;
 }
 
 size_t SparkplugClient::encodePayload(org_eclipse_tahu_protobuf_Payload *payload, uint8_t **buffer)
 {
-    size_t message_length = encode_payload(nullptr, MAX_BUFFER_LENGTH, payload);
-    *buffer = (uint8_t *)malloc(message_length * sizeof(uint8_t));
-    encode_payload(*buffer, message_length, payload);
-    return message_length;
+    if (!reserveEncodeBuffer(MAX_BUFFER_LENGTH))
+    {
+        return 0;
+    }
+
+    ssize_t length = encode_payload(encodeBuffer, encodeBufferLength, payload);
+
+    if (length < 0)
+    {
+        // The payload did not fit, size it and grow the buffer before encoding again
+        ssize_t required = encode_payload(NULL, 0, payload);
+
+        if (required < 0 || !reserveEncodeBuffer(required))
+        {
+            LOGGER("Failed to encode payload\n");
+            return 0;
+        }
+
+        length = encode_payload(encodeBuffer, encodeBufferLength, payload);
+
+        if (length < 0)
+        {
+            LOGGER("Failed to encode payload\n");
+            return 0;
+        }
+    }
+
+    *buffer = encodeBuffer;
+    return length;
+}
+
+int SparkplugClient::prepareBirth(PublishRequest *publishRequest, uint64_t encodeStart)
+{
+    std::vector<uint8_t> &encoded = publishRequest->encoded;
+    uint64_t timestamp = TimeManager::getTime();
+
+    int result = publishRequest->publisher->encodeBirth(encoded, timestamp);
+
+    if (result == 0 && publishRequest->publisher->isNode())
+    {
+        auto bdSeqMetric = Int64Metric::create("bdSeq", bdSeq);
+        result = bdSeqMetric->appendBirth(encoded, timestamp);
+    }
+
+    if (result != 0)
+    {
+        LOGGER("Failed to encode birth\n");
+        encoded.clear();
+        return -1;
+    }
+
+    publishRequest->encodedLength = encoded.size();
+
+    statistics.encodeTime.record(statisticsTime() - encodeStart);
+    return 0;
+}
+
+int SparkplugClient::prepareRequest(PublishRequest *publishRequest)
+{
+    if (publishRequest->encodedLength > 0)
+    {
+        return 0;
+    }
+
+    uint64_t encodeStart = statisticsTime();
+
+    if (publishRequest->isBirth)
+    {
+        return prepareBirth(publishRequest, encodeStart);
+    }
+
+    // The request's buffer is kept between pooled requests, so it is usually large enough already
+    std::vector<uint8_t> &encoded = publishRequest->encoded;
+    encoded.reserve(MAX_BUFFER_LENGTH);
+
+    if (publishRequest->publisher->encodeData(encoded, TimeManager::getTime()) != 0)
+    {
+        LOGGER("Failed to encode payload\n");
+        encoded.clear();
+        return -1;
+    }
+
+    publishRequest->encodedLength = encoded.size();
+
+    statistics.encodeTime.record(statisticsTime() - encodeStart);
+    return 0;
+}
+
+size_t SparkplugClient::sequenceEncodedPayload(PublishRequest *publishRequest, uint8_t **buffer)
+{
+    std::vector<uint8_t> &encoded = publishRequest->encoded;
+
+    // A retry is sent with the sequence of its first attempt, so the host sees sequences in the order requests were first sent
+    if (encoded.size() > publishRequest->encodedLength)
+    {
+        *buffer = encoded.data();
+        return encoded.size();
+    }
+
+    // Protobuf allows fields in any order, so the seq field can follow the encoded metrics
+    LOGGER("Current Sequence Number: %u\n", payloadSequence);
+    uint64_t sequence = payloadSequence++;
+    encoded.push_back(PAYLOAD_SEQUENCE_KEY);
+    appendProtobufVarint(encoded, sequence);
+
+    *buffer = encoded.data();
+    return encoded.size();
 }
 
 void SparkplugClient::destroyRequest(PublishRequest *publishRequest)
 {
+    if (publishRequest->pool != NULL)
+    {
+        publishRequest->pool->release(publishRequest);
+        return;
+    }
     delete publishRequest;
 }
 
@@ -275,6 +411,44 @@ bool SparkplugClient::getPrimary()
     return isPrimary;
 }
 
+#ifdef CPP_SPARKPLUG_COMPRESSION
+void SparkplugClient::enableCompression(CompressionAlgorithm algorithm, size_t threshold)
+{
+    compression = algorithm;
+    compressionThreshold = threshold;
+}
+
+size_t SparkplugClient::compressEncodedPayload(uint8_t **buffer, size_t length)
+{
+    org_eclipse_tahu_protobuf_Payload envelope;
+
+    if (compressPayload(compression, *buffer, length, &envelope) != 0)
+    {
+        return length;
+    }
+
+    // The original payload is held by the request, so the envelope is encoded once into the encode buffer.
+    // The envelope is only used when it is smaller than the original payload, so anything that does not fit
+    // in one byte less than the original is sent uncompressed.
+    if (length <= 1 || !reserveEncodeBuffer(length))
+    {
+        free_payload(&envelope);
+        return length;
+    }
+
+    ssize_t envelopeLength = encode_payload(encodeBuffer, length - 1, &envelope);
+    free_payload(&envelope);
+
+    if (envelopeLength <= 0)
+    {
+        return length;
+    }
+
+    *buffer = encodeBuffer;
+    return envelopeLength;
+}
+#endif
+
 int SparkplugClient::processRequest(PublishRequest *publishRequest)
 {
     if (getState() == DISCONNECTED)
@@ -285,39 +459,59 @@ int SparkplugClient::processRequest(PublishRequest *publishRequest)
 
     setState(PUBLISHING_PAYLOAD);
 
-    if (publishRequest->publisher->isNode() && publishRequest->isBirth)
+    // A retried request already carries the sequence it was first sent with
+    bool sequenced = publishRequest->encodedLength > 0 && publishRequest->encoded.size() > publishRequest->encodedLength;
+
+    if (publishRequest->publisher->isNode() && publishRequest->isBirth && !sequenced)
     {
         resetSequence();
     }
 
-    org_eclipse_tahu_protobuf_Payload *payload = initializePayload();
-
-    publishRequest->publisher->addToPayload(payload, publishRequest->isBirth);
-
-    if (publishRequest->publisher->isNode() && publishRequest->isBirth)
+    // Requests are only encoded once, retries reuse the encoded payload and its sequence
+    if (prepareRequest(publishRequest) != 0)
     {
-        auto bdSeqMetric = Int64Metric::create("bdSeq", bdSeq);
-        bdSeqMetric->addToPayload(payload, true);
+        return -1;
     }
 
-    uint8_t *buffer;
-    size_t length = encodePayload(payload, &buffer);
+    uint8_t *buffer = NULL;
+    size_t length = sequenceEncodedPayload(publishRequest, &buffer);
 
-    free_payload(payload);
-    free(payload);
+#ifdef CPP_SPARKPLUG_COMPRESSION
+    if (length > 0 && compression != COMPRESSION_NONE && length >= compressionThreshold)
+    {
+        length = compressEncodedPayload(&buffer, length);
+    }
+#endif
 
     int returnCode = -1;
 
     if (length > 0)
     {
+        uint64_t now = statisticsTime();
+
+        if (publishRequest->retryCount > 0)
+        {
+            statistics.retries.add();
+        }
+        else if (publishRequest->requestTime > 0)
+        {
+            statistics.queueLatency.record(now - publishRequest->requestTime);
+        }
+        publishRequest->sendTime = now;
+
         returnCode = publishMessage(
-            publishRequest->topic,
+            *publishRequest->topic,
             buffer,
             length,
             &publishRequest->token);
     }
 
-    free(buffer);
+    if (returnCode == 0)
+    {
+        statistics.published.add();
+        statistics.bytesPublished.add(length);
+        statistics.payloadSize.record(length);
+    }
 
     return returnCode;
 }
@@ -355,23 +549,39 @@ void SparkplugClient::disconnected(const char *cause)
 
 void SparkplugClient::delivered(PublishRequest *publishRequest)
 {
+    statistics.delivered.add();
+    if (publishRequest->sendTime > 0)
+    {
+        statistics.deliveryLatency.record(statisticsTime() - publishRequest->sendTime);
+    }
     handler->onEvent(this, CLIENT_DELIVERED, publishRequest->publisher);
     SparkplugClient::destroyRequest(publishRequest);
 }
 
 void SparkplugClient::undelivered(PublishRequest *publishRequest)
 {
-    handler->onEvent(this, CLIENT_UNDELIVERED, publishRequest->publisher);
-    SparkplugClient::destroyRequest(publishRequest);
+    statistics.undelivered.add();
+    // The handler owns the request from here, so it can keep the payload that failed to send
+    handler->onEvent(this, CLIENT_UNDELIVERED, publishRequest);
 }
 
-void SparkplugClient::messageReceived(const string &topic, void *payload, int payloadLength)
+void SparkplugClient::messageReceived(std::string_view topic, const void *payload, int payloadLength)
 {
     MessageEventStruct messageEvent = {
-        std::string(topic), payload, payloadLength};
+        topic, payload, payloadLength};
     handler->onEvent(this, CLIENT_MESSAGE, &messageEvent);
 }
 
+void SparkplugClient::messageReceived(MessageEventStruct &message)
+{
+    handler->onEvent(this, CLIENT_MESSAGE, &message);
+}
+
+ClientStatistics &SparkplugClient::getStatistics()
+{
+    return statistics;
+}
+
 void SparkplugClient::execute()
 {
     if (state == DISCONNECTED)
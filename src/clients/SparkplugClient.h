@@ -37,6 +37,11 @@
 #include "CommonTypes.h"
 #include "../Publishable.h"
 #include <string>
+#include <string_view>
+#include "utils/Statistics.h"
+#ifdef CPP_SPARKPLUG_COMPRESSION
+#include "utils/Compression.h"
+#endif
 
 #define MAX_TOPIC_LENGTH 256
 #define MAX_BUFFER_LENGTH 512
@@ -49,44 +54,121 @@ enum EventType
     CLIENT_DISCONNECTED,
     CLIENT_ACTIVE,
     CLIENT_DEACTIVE,
+    /**
+     * @brief A publish was delivered. The data is the Publishable that was published.
+     */
     CLIENT_DELIVERED,
+    /**
+     * @brief A publish could not be delivered. The data is the PublishRequest, holding the payload that failed to send.
+     * The handler takes ownership of the request, and must release it with SparkplugClient::destroyRequest.
+     */
     CLIENT_UNDELIVERED
 };
 
+/**
+ * @brief Callback used to free a transport message once it has been dispatched
+ *
+ * @param message The transport message
+ * @param topic The transport topic buffer
+ */
+typedef void (*MessageReleaseCallback)(void *message, char *topic);
+
+/**
+ * @brief Data for a message received by a SparkplugClient.
+ * A message either borrows its topic and payload for the duration of the event, or owns the
+ * transport message it was created from, in which case the message is released through a callback
+ * once the event has been dispatched. Owned messages can be moved into a queue without copying.
+ */
 struct MessageEventStruct
 {
 private:
     void *raw = nullptr;
+    void *message = nullptr;
+    char *topicBuffer = nullptr;
+    MessageReleaseCallback release = nullptr;
 
-    void *copyBuffer(const void *source, size_t length)
+    void *copyBuffer(std::string_view topic, const void *source, size_t length)
     {
-        void *buffer;
-        buffer = malloc(length);
+        // Payload and topic are copied into a single allocation
+        uint8_t *buffer;
+        buffer = (uint8_t *)malloc(length + topic.size());
         memcpy(buffer, source, length);
+        memcpy(buffer + length, topic.data(), topic.size());
         return buffer;
     }
 
 public:
-    MessageEventStruct(std::string topic, void *payload, int payloadLength)
+    /**
+     * @brief Construct a message that borrows the topic and payload
+     *
+     * @param topic The topic the message was received on
+     * @param payload The payload of the message
+     * @param payloadLength The length of the payload
+     */
+    MessageEventStruct(std::string_view topic, const void *payload, int payloadLength)
         : topic(topic), payload(payload), payloadLength(payloadLength) {}
 
-    MessageEventStruct(MessageEventStruct &source) : raw(copyBuffer(source.payload, source.payloadLength)),
-                                                     topic(std::string(source.topic)),
+    /**
+     * @brief Construct a message that takes ownership of a transport message
+     *
+     * @param topic The topic the message was received on
+     * @param payload The payload of the message
+     * @param payloadLength The length of the payload
+     * @param message The transport message which holds the payload
+     * @param topicBuffer The transport buffer which holds the topic
+     * @param release Callback used to free the message and topic buffer
+     */
+    MessageEventStruct(std::string_view topic, const void *payload, int payloadLength,
+                       void *message, char *topicBuffer, MessageReleaseCallback release)
+        : message(message), topicBuffer(topicBuffer), release(release),
+          topic(topic), payload(payload), payloadLength(payloadLength) {}
+
+    MessageEventStruct(MessageEventStruct &source) : raw(copyBuffer(source.topic, source.payload, source.payloadLength)),
+                                                     topic((char *)raw + source.payloadLength, source.topic.size()),
                                                      payload(raw),
                                                      payloadLength(source.payloadLength)
 
     {
     }
 
+    MessageEventStruct(MessageEventStruct &&source) : raw(source.raw),
+                                                      message(source.message),
+                                                      topicBuffer(source.topicBuffer),
+                                                      release(source.release),
+                                                      topic(source.topic),
+                                                      payload(source.payload),
+                                                      payloadLength(source.payloadLength)
+    {
+        source.raw = nullptr;
+        source.release = nullptr;
+    }
+
+    MessageEventStruct &operator=(const MessageEventStruct &) = delete;
+
     ~MessageEventStruct()
     {
+        if (release)
+        {
+            release(message, topicBuffer);
+        }
         if (raw)
         {
             free(raw);
         }
     }
 
-    const std::string topic;
+    /**
+     * @brief Whether the message owns its data and can be moved rather than copied
+     *
+     * @return true The message owns its data
+     * @return false The message borrows its data
+     */
+    bool isOwned()
+    {
+        return release != nullptr || raw != nullptr;
+    }
+
+    const std::string_view topic;
     const void *payload;
     const int payloadLength;
 };
@@ -117,6 +199,11 @@ typedef struct
     const char *password;
     int connectTimeout;
     int keepAliveInterval;
+    /**
+     * @brief Maximum number of publishes that can be awaiting delivery at once. 0 uses the client default.
+     * Failed publishes are retried with their original sequence number, and hold back new publishes until they are delivered.
+     */
+    int maxInflight = 0;
 } ClientOptions;
 
 /**
@@ -157,16 +244,61 @@ private:
     ClientEventHandler *handler = NULL;
     int64_t bdSeq = 255;
     uint8_t payloadSequence = 0;
+    uint8_t *encodeBuffer = NULL;
+    size_t encodeBufferLength = 0;
+#ifdef CPP_SPARKPLUG_COMPRESSION
+    CompressionAlgorithm compression = COMPRESSION_NONE;
+    size_t compressionThreshold = 0;
 
+    /**
+     * @brief Replaces an encoded payload with a compressed payload envelope, if compressing makes the payload smaller.
+     *
+     * @param buffer A pointer to the buffer containing the encoded payload, updated to the buffer containing the envelope
+     * @param length The size of the encoded payload
+     * @return The size of the payload that will be published
+     */
+    size_t compressEncodedPayload(uint8_t **buffer, size_t length);
+#endif
+
+    /**
+     * @brief Grows the encode buffer so it can hold at least the requested number of bytes.
+     * The buffer is grown geometrically to keep the number of reallocations low.
+     *
+     * @param length The minimum size of the buffer
+     * @return true if the buffer is large enough
+     */
+    bool reserveEncodeBuffer(size_t length);
     /**
      * @brief Encodes a Sparkplug protobuf payload into a raw byte buffer.
+     * The payload is encoded into a scratch buffer owned by the client that is reused across publishes,
+     * the buffer is only valid until the next payload is encoded.
      *
      * @param payload The Sparkplug protobuf payload to encode
-     * @param buffer A pointer to a buffer array that will contain the payload
-     * @return The size of the encoded buffer
+     * @param buffer A pointer that will be set to the buffer containing the payload
+     * @return The size of the encoded buffer, or 0 if the payload failed to encode
      */
     size_t encodePayload(org_eclipse_tahu_protobuf_Payload *payload, uint8_t **buffer);
 
+    /**
+     * @brief Appends the next payload sequence to an encoded payload.
+     * The sequence is assigned when the payload is first sent, so sequences follow the order payloads are first sent in.
+     * A retried payload keeps the sequence it was first sent with.
+     *
+     * @param publishRequest The request holding the encoded payload
+     * @param buffer A pointer that will be set to the buffer containing the payload
+     * @return The size of the payload including the sequence
+     */
+    size_t sequenceEncodedPayload(PublishRequest *publishRequest, uint8_t **buffer);
+
+    /**
+     * @brief Encodes the birth payload of a PublishRequest from the cached birth encodings of its metrics
+     *
+     * @param publishRequest The birth request
+     * @param encodeStart The time encoding started, for statistics
+     * @return 0 if the payload was encoded
+     */
+    int prepareBirth(PublishRequest *publishRequest, uint64_t encodeStart);
+
     /**
      * @brief Increments the bdSeq
      */
@@ -177,12 +309,12 @@ private:
     void resetSequence();
     /**
      * @brief Intializes a payload for publishing
-     * The returned payload needs to be freed
+     * The returned payload needs to be freed. Payloads are encoded without a sequence,
+     * the sequence is appended when the payload is sent.
      *
-     * @param hasSeq Whether the payload will have a sequence
      * @return org_eclipse_tahu_protobuf_Payload*
      */
-    org_eclipse_tahu_protobuf_Payload *initializePayload(bool hasSeq = true);
+    org_eclipse_tahu_protobuf_Payload *initializePayload();
 
     /**
      * @brief Get the Sparkplug Payload that will be used to publish.
@@ -193,11 +325,12 @@ private:
 
 protected:
     ClientTopicOptions *topics;
+    ClientStatistics statistics;
 
     /**
      * @brief Builds a will payload
      *
-     * @param buffer A pointer to a buffer to fill with the will payload
+     * @param buffer A pointer that will be set to the buffer containing the will payload. The buffer is owned by the client.
      * @return size_t The size of the will payload
      */
     size_t getWillPayload(uint8_t **buffer);
@@ -287,7 +420,14 @@ protected:
      */
     void delivered(PublishRequest *publishRequest);
     void undelivered(PublishRequest *publishRequest);
-    void messageReceived(const std::string &topic, void *payload, int payloadLength);
+    void messageReceived(std::string_view topic, const void *payload, int payloadLength);
+    /**
+     * @brief Informs the handler of a received message, handing over ownership of the transport message.
+     * The message is released through the callback once it has been dispatched.
+     *
+     * @param message The received message
+     */
+    void messageReceived(MessageEventStruct &message);
     void setState(ClientState state);
     /**
      * @brief Sets the SparkplugClient as the Primary Client
@@ -317,6 +457,16 @@ public:
      */
     SparkplugClient(ClientEventHandler *handler, ClientOptions *options);
     virtual ~SparkplugClient();
+#ifdef CPP_SPARKPLUG_COMPRESSION
+    /**
+     * @brief Enables compression of published payloads. Payloads at least the threshold in size are sent
+     * as a Sparkplug compressed payload envelope, as long as compressing makes them smaller.
+     *
+     * @param algorithm The algorithm used to compress payloads, COMPRESSION_NONE disables compression
+     * @param threshold The minimum size of an encoded payload before it is compressed
+     */
+    void enableCompression(CompressionAlgorithm algorithm, size_t threshold);
+#endif
     /**
      * @brief Configures the SparkplugClient by setting up a MQTT Client and setting the required
      * Sparkplug topics.
@@ -367,12 +517,28 @@ public:
      */
     ClientState getState();
     /**
-     * @brief Frees memory used by a PublishRequest.
+     * @brief Encodes the payload of a PublishRequest without a sequence, if it has not been encoded already.
+     * Lets a payload be encoded ahead of the send, on the thread requesting the publish, leaving only the sequence
+     * to be added when the payload is sent. Must not be called while the request is being sent.
+     *
+     * @param publishRequest
+     * @return 0 if the payload was encoded
+     */
+    int prepareRequest(PublishRequest *publishRequest);
+    /**
+     * @brief Frees memory used by a PublishRequest, returning it to its pool if it was acquired from one.
      *
      * @param publishRequest
      */
     static void destroyRequest(PublishRequest *publishRequest);
 
+    /**
+     * @brief Get the publish statistics of the client. Statistics can be read from any thread.
+     *
+     * @return ClientStatistics&
+     */
+    ClientStatistics &getStatistics();
+
     /**
      * @brief Assures the SparkplugClient is connected and synced to the broker.
      * Called by the node on every execute.
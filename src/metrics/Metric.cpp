@@ -33,13 +33,26 @@
 
 #include "Metric.h"
 #include "properties/simple/BooleanProperty.h"
+#include "utils/Protobuf.h"
 #include <pb_decode.h>
+#include <pb_encode.h>
 #include <iostream>
 
+#ifdef DEBUGGING
+#define LOGGER(format, ...) \
+    printf("Metric: ");     \
+    printf(format, ##__VA_ARGS__)
+#else
+#define LOGGER(out, ...)
+#endif
+
 Metric::~Metric()
 {
     free(name);
-    free(data);
+    if (ownsData)
+    {
+        free(data);
+    }
 }
 
 Metric::Metric(const char *name, void *data, size_t size, uint8_t dataType) : dataType(dataType)
@@ -50,12 +63,26 @@ Metric::Metric(const char *name, void *data, size_t size, uint8_t dataType) : da
     memcpy(this->data, data, size);
 }
 
+Metric::Metric(const char *name, size_t size, uint8_t dataType) : dataType(dataType), ownsData(false)
+{
+    this->name = strdup(name);
+    this->size = size;
+}
+
 void Metric::addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBirth)
 {
     if (dirty || isBirth)
     {
         org_eclipse_tahu_protobuf_Payload_Metric metric;
-        if (init_metric(&metric, name, true, alias, dataType, false, false, data, size) != 0)
+
+        if (!isBirth)
+        {
+            addHistoryToPayload(payload);
+        }
+
+        // Once a metric has been born with an alias, data messages only need to carry the alias
+        const char *metricName = (isBirth || alias == 0) ? name : NULL;
+        if (initPayloadMetric(&metric, metricName, isBirth) != 0)
         {
         }
 
@@ -86,16 +113,401 @@ void Metric::addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBir
     }
 }
 
+int Metric::appendBirth(std::vector<uint8_t> &buffer, uint64_t timestamp)
+{
+    if (birthCache == NULL)
+    {
+        pb_ostream_t stream = protobufStreamFromVector(buffer);
+
+        if (!encodeProtobufSubmessage(&stream, org_eclipse_tahu_protobuf_Payload_metrics_tag, [&](pb_ostream_t *substream)
+                                      { return encodeFields(substream, name, data, &timestamp, false, true); }))
+        {
+            LOGGER("Failed to encode %s\n", name);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (!isBirthEncodingValid() && encodeBirth() != 0)
+    {
+        return -1;
+    }
+
+    std::vector<uint8_t> &encoding = birthCache->encoding;
+
+    // Protobuf allows fields in any order, so the timestamp can follow the cached fields
+    buffer.push_back(PAYLOAD_METRIC_KEY);
+    appendProtobufVarint(buffer, encoding.size() + 1 + protobufVarintSize(timestamp));
+    buffer.insert(buffer.end(), encoding.begin(), encoding.end());
+    buffer.push_back(METRIC_TIMESTAMP_KEY);
+    appendProtobufVarint(buffer, timestamp);
+
+    return 0;
+}
+
+int Metric::enableBirthCache(bool enabled)
+{
+    if (!enabled)
+    {
+        birthCache.reset();
+        return 0;
+    }
+
+    if (dataType == METRIC_DATA_TYPE_DATASET)
+    {
+        return -1;
+    }
+
+    if (birthCache == NULL)
+    {
+        birthCache = std::make_unique<BirthCache>();
+    }
+    return 0;
+}
+
+void Metric::invalidateBirth()
+{
+    if (birthCache != NULL)
+    {
+        birthCache->encoding.clear();
+    }
+}
+
+bool Metric::isBirthEncodingValid()
+{
+    std::vector<uint8_t> &birthValue = birthCache->value;
+
+    if (birthCache->encoding.empty() || birthValue.size() != size || (size > 0 && memcmp(birthValue.data(), data, size) != 0))
+    {
+        return false;
+    }
+
+    for (auto &property : properties)
+    {
+        if (property->isDirty())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int Metric::encodeBirth()
+{
+    birthCache->encoding.clear();
+    pb_ostream_t stream = protobufStreamFromVector(birthCache->encoding);
+
+    // The timestamp is left out, it is written for every birth after the cached fields
+    if (!encodeFields(&stream, name, data, NULL, false, true))
+    {
+        LOGGER("Failed to encode %s\n", name);
+        birthCache->encoding.clear();
+        return -1;
+    }
+
+    birthCache->value.assign((uint8_t *)data, (uint8_t *)data + (data != NULL ? size : 0));
+    return 0;
+}
+
+/**
+ * @brief Writes the value field of a protobuf metric, for the types metrics are stored as
+ *
+ * @return true if the value was written
+ */
+static bool encodeMetricValue(pb_ostream_t *stream, uint8_t dataType, void *value)
+{
+    switch (dataType)
+    {
+    case METRIC_DATA_TYPE_INT8:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag) &&
+               pb_encode_varint(stream, (uint32_t)(*(int8_t *)value));
+    case METRIC_DATA_TYPE_INT16:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag) &&
+               pb_encode_varint(stream, (uint32_t)(*(int16_t *)value));
+    case METRIC_DATA_TYPE_INT32:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag) &&
+               pb_encode_varint(stream, (uint32_t)(*(int32_t *)value));
+    case METRIC_DATA_TYPE_UINT8:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag) &&
+               pb_encode_varint(stream, *(uint8_t *)value);
+    case METRIC_DATA_TYPE_UINT16:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag) &&
+               pb_encode_varint(stream, *(uint16_t *)value);
+    case METRIC_DATA_TYPE_UINT32:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_int_value_tag) &&
+               pb_encode_varint(stream, *(uint32_t *)value);
+    case METRIC_DATA_TYPE_INT64:
+    case METRIC_DATA_TYPE_UINT64:
+    case METRIC_DATA_TYPE_DATETIME:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_long_value_tag) &&
+               pb_encode_varint(stream, *(uint64_t *)value);
+    case METRIC_DATA_TYPE_FLOAT:
+        return pb_encode_tag(stream, PB_WT_32BIT, org_eclipse_tahu_protobuf_Payload_Metric_float_value_tag) &&
+               pb_encode_fixed32(stream, value);
+    case METRIC_DATA_TYPE_DOUBLE:
+        return pb_encode_tag(stream, PB_WT_64BIT, org_eclipse_tahu_protobuf_Payload_Metric_double_value_tag) &&
+               pb_encode_fixed64(stream, value);
+    case METRIC_DATA_TYPE_BOOLEAN:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_boolean_value_tag) &&
+               pb_encode_varint(stream, *(bool *)value);
+    case METRIC_DATA_TYPE_STRING:
+    case METRIC_DATA_TYPE_TEXT:
+    case METRIC_DATA_TYPE_UUID:
+        return pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_Metric_string_value_tag) &&
+               pb_encode_string(stream, (const pb_byte_t *)value, strlen((char *)value));
+    default:
+        return false;
+    }
+}
+
+int Metric::initPayloadMetric(org_eclipse_tahu_protobuf_Payload_Metric *metric, const char *metricName, __attribute__((unused)) bool isBirth)
+{
+    return init_metric(metric, metricName, alias != 0, alias, dataType, false, false, data, size);
+}
+
+bool Metric::encodeValue(pb_ostream_t *stream, void *value, __attribute__((unused)) bool isBirth)
+{
+    return encodeMetricValue(stream, dataType, value);
+}
+
+bool Metric::encodeFields(pb_ostream_t *stream, const char *metricName, void *value, const uint64_t *timestamp, bool isHistorical, bool isBirth)
+{
+    // Fields are written in field number order, as nanopb would encode the struct form
+    if (metricName != NULL &&
+        !(pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_Metric_name_tag) &&
+          pb_encode_string(stream, (const pb_byte_t *)metricName, strlen(metricName))))
+    {
+        return false;
+    }
+
+    if (alias != 0 &&
+        !(pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_alias_tag) &&
+          pb_encode_varint(stream, alias)))
+    {
+        return false;
+    }
+
+    if (timestamp != NULL &&
+        !(pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_timestamp_tag) &&
+          pb_encode_varint(stream, *timestamp)))
+    {
+        return false;
+    }
+
+    if (!pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_datatype_tag) ||
+        !pb_encode_varint(stream, dataType))
+    {
+        return false;
+    }
+
+    if (isHistorical &&
+        !(pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_is_historical_tag) &&
+          pb_encode_varint(stream, true)))
+    {
+        return false;
+    }
+
+    if (value == NULL)
+    {
+        if (!pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_Metric_is_null_tag) ||
+            !pb_encode_varint(stream, true))
+        {
+            return false;
+        }
+    }
+
+    if (!isHistorical)
+    {
+        for (auto &property : properties)
+        {
+            if (!property->isIncluded(isBirth))
+            {
+                continue;
+            }
+
+            if (!encodeProtobufSubmessage(stream, org_eclipse_tahu_protobuf_Payload_Metric_properties_tag, [this, isBirth](pb_ostream_t *substream)
+                                          { return Property::encodePropertySet(substream, properties, isBirth); }))
+            {
+                return false;
+            }
+            break;
+        }
+    }
+
+    return value == NULL || encodeValue(stream, value, isBirth);
+}
+
+int Metric::encode(pb_ostream_t *stream, bool isBirth)
+{
+    if (!dirty && !isBirth)
+    {
+        return 0;
+    }
+
+    // Once a metric has been born with an alias, data messages only need to carry the alias
+    const char *metricName = (isBirth || alias == 0) ? name : NULL;
+
+    if (!isBirth && history != NULL)
+    {
+        for (size_t i = 0; i < history->count; i++)
+        {
+            size_t index = (history->start + i) % history->capacity;
+            void *value = history->values + index * history->size;
+            uint64_t timestamp = history->times[index];
+
+            if (!encodeProtobufSubmessage(stream, org_eclipse_tahu_protobuf_Payload_metrics_tag, [&](pb_ostream_t *substream)
+                                          { return encodeFields(substream, metricName, value, &timestamp, true, false); }))
+            {
+                LOGGER("Failed to encode %s\n", name);
+                return -1;
+            }
+        }
+    }
+
+    uint64_t timestamp = isBirth ? TimeManager::getTime() : changedTime;
+
+    if (!encodeProtobufSubmessage(stream, org_eclipse_tahu_protobuf_Payload_metrics_tag, [&](pb_ostream_t *substream)
+                                  { return encodeFields(substream, metricName, data, &timestamp, false, isBirth); }))
+    {
+        LOGGER("Failed to encode %s\n", name);
+        return -1;
+    }
+
+    return 0;
+}
+
 void Metric::setValue(void *data)
 {
+    MetricLock lock = lockOwner();
+
     if (dirty || memcmp(data, this->data, size) != 0)
     {
-        dirty = true;
+        if (dirty && memcmp(data, this->data, size) != 0)
+        {
+            recordHistory();
+        }
         memcpy(this->data, data, size);
         changedTime = TimeManager::getTime();
+        markDirty();
     }
 };
 
+void Metric::recordHistory()
+{
+    // Values that have changed size since history was enabled can not be stored
+    if (history == NULL || size != history->size)
+    {
+        return;
+    }
+
+    size_t index = (history->start + history->count) % history->capacity;
+
+    if (history->count == history->capacity)
+    {
+        history->start = (history->start + 1) % history->capacity;
+    }
+    else
+    {
+        history->count++;
+    }
+
+    memcpy(history->values + index * history->size, data, history->size);
+    history->times[index] = changedTime;
+}
+
+void Metric::addHistoryToPayload(org_eclipse_tahu_protobuf_Payload *payload)
+{
+    if (history == NULL)
+    {
+        return;
+    }
+
+    bool hasAlias = alias != 0;
+    const char *metricName = hasAlias ? NULL : name;
+
+    for (size_t i = 0; i < history->count; i++)
+    {
+        size_t index = (history->start + i) % history->capacity;
+        org_eclipse_tahu_protobuf_Payload_Metric metric;
+
+        if (init_metric(&metric, metricName, hasAlias, alias, dataType, true, false, history->values + index * history->size, history->size) != 0)
+        {
+            continue;
+        }
+
+        metric.has_timestamp = true;
+        metric.timestamp = history->times[index];
+
+        if (add_metric_to_payload(payload, &metric) < 0)
+        {
+            // TODO: failure
+        }
+    }
+}
+
+int Metric::enableHistory(size_t samples)
+{
+    history.reset();
+
+    if (samples == 0)
+    {
+        return 0;
+    }
+
+    auto buffer = std::make_unique<History>();
+    buffer->values = (uint8_t *)malloc(samples * size);
+    buffer->times = (uint64_t *)malloc(samples * sizeof(uint64_t));
+
+    if (buffer->values == NULL || buffer->times == NULL)
+    {
+        return -1;
+    }
+
+    buffer->size = size;
+    buffer->capacity = samples;
+    history = std::move(buffer);
+    return 0;
+}
+
+void Metric::hold()
+{
+    if (held || owner == NULL)
+    {
+        return;
+    }
+
+    held = true;
+    owner->onMetricHeld(this);
+}
+
+int32_t Metric::releaseHeld(__attribute__((unused)) time_t now)
+{
+    return 0;
+}
+
+int32_t Metric::checkHeld(time_t now)
+{
+    int32_t remaining = releaseHeld(now);
+    held = remaining > 0;
+    return remaining;
+}
+
+void Metric::markDirty()
+{
+    if (dirty)
+    {
+        return;
+    }
+
+    dirty = true;
+
+    if (owner != NULL)
+    {
+        owner->onMetricDirty(this);
+    }
+}
+
 bool Metric::isDirty()
 {
     return dirty;
@@ -104,11 +516,21 @@ bool Metric::isDirty()
 void Metric::published()
 {
     dirty = false;
+    if (history != NULL)
+    {
+        history->count = 0;
+        history->start = 0;
+    }
     if (properties.size() > 0)
     {
 
         for (auto &property : properties)
         {
+            // Published property changes are not part of the cached birth
+            if (property->isDirty())
+            {
+                invalidateBirth();
+            }
             property->published();
         }
     }
@@ -124,9 +546,43 @@ const char *Metric::getName()
     return name;
 }
 
+uint64_t Metric::getAlias()
+{
+    return alias;
+}
+
+void Metric::setAlias(uint64_t alias)
+{
+    this->alias = alias;
+    invalidateBirth();
+}
+
+void Metric::setOwner(MetricOwner *owner)
+{
+    this->owner = owner;
+    // A new owner does not know of a change held for the previous owner
+    held = false;
+}
+
+MetricOwner *Metric::getOwner()
+{
+    return owner;
+}
+
+Metric *Metric::getNextDirty()
+{
+    return nextDirty;
+}
+
+void Metric::setNextDirty(Metric *metric)
+{
+    nextDirty = metric;
+}
+
 void Metric::addProperty(const std::shared_ptr<Property> &property)
 {
     properties.push_back(std::move(property));
+    invalidateBirth();
 }
 
 void Metric::addProperties(const std::vector<std::shared_ptr<Property>> &properties)
@@ -37,6 +37,9 @@
 #include <functional>
 #include <memory>
 #include <time.h>
+#ifdef _GLIBCXX_HAS_GTHREADS
+#include <mutex>
+#endif
 #include "utils/TimeManager.h"
 #include "../properties/Property.h"
 
@@ -52,6 +55,59 @@ public:
     virtual void onMetricCommand(Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload) = 0;
 };
 
+/**
+ * @brief Class for handling when a Metric becomes dirty, or holds back a change that can be published later.
+ * Both callbacks are made while the owner's metrics lock is held.
+ *
+ */
+class MetricOwner
+{
+public:
+    virtual void onMetricDirty(Metric *metric) = 0;
+    virtual void onMetricHeld(Metric *metric) = 0;
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+    /**
+     * @brief Guards the values and dirty state of the owner's metrics. Held while a metric is changed, and while the owner
+     * updates, encodes or publishes its metrics, so metrics can be set from another thread while a Node runs begin.
+     */
+    std::mutex metricsMutex;
+#endif
+};
+
+/**
+ * @brief Holds the metrics lock of a metric's owner for as long as it is in scope. Metrics without an owner are not locked.
+ *
+ */
+class MetricLock
+{
+#ifdef _GLIBCXX_HAS_GTHREADS
+private:
+    std::mutex *mutex;
+
+public:
+    MetricLock(MetricOwner *owner) : mutex(owner != NULL ? &owner->metricsMutex : NULL)
+    {
+        if (mutex != NULL)
+        {
+            mutex->lock();
+        }
+    };
+    ~MetricLock()
+    {
+        if (mutex != NULL)
+        {
+            mutex->unlock();
+        }
+    };
+#else
+public:
+    MetricLock(__attribute__((unused)) MetricOwner *owner){};
+#endif
+    MetricLock(const MetricLock &) = delete;
+    MetricLock &operator=(const MetricLock &) = delete;
+};
+
 /**
  * @brief
  *
@@ -64,10 +120,78 @@ private:
     uint64_t alias = 0;
     uint8_t dataType;
 
+    bool ownsData = true;
+
     CommandHandler *handler = NULL;
+    MetricOwner *owner = NULL;
+    Metric *nextDirty = NULL;
+    bool held = false;
+
     std::function<void(Metric *, org_eclipse_tahu_protobuf_Payload_Metric *)> callback;
     bool isReadOnly = true;
 
+    /**
+     * @brief The birth encoding of the metric, without its timestamp, along with the value it was encoded from
+     */
+    struct BirthCache
+    {
+        std::vector<uint8_t> encoding;
+        std::vector<uint8_t> value;
+    };
+
+    std::unique_ptr<BirthCache> birthCache;
+
+    /**
+     * @brief A ring of the values replaced before the metric was published, along with the times they were set
+     */
+    struct History
+    {
+        uint8_t *values = NULL;
+        uint64_t *times = NULL;
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t count = 0;
+        size_t start = 0;
+
+        ~History()
+        {
+            free(values);
+            free(times);
+        }
+    };
+
+    std::unique_ptr<History> history;
+
+    /**
+     * @brief Discards the cached birth encoding, if the birth cache is enabled
+     */
+    void invalidateBirth();
+    /**
+     * @brief Whether the cached birth encoding matches the current value and properties of the metric
+     *
+     * @return true
+     * @return false
+     */
+    bool isBirthEncodingValid();
+    /**
+     * @brief Encodes the metric as it appears in a birth, without its timestamp, into the birth cache
+     *
+     * @return int 0 on success, -1 if the metric could not be encoded
+     */
+    int encodeBirth();
+    /**
+     * @brief Writes the fields of a protobuf metric straight from a value, without building the struct form of the metric
+     *
+     * @param stream The stream the metric is written to
+     * @param metricName The name of the metric, or NULL if only the alias is sent
+     * @param value The value of the metric
+     * @param timestamp The timestamp of the metric, or NULL to leave it out
+     * @param isHistorical If the value is a historical value, which are written without properties
+     * @param isBirth If the metric is a part of a birth message
+     * @return true if the metric was encoded
+     */
+    bool encodeFields(pb_ostream_t *stream, const char *metricName, void *value, const uint64_t *timestamp, bool isHistorical, bool isBirth);
+
 protected:
     time_t changedTime = 0;
     std::vector<std::shared_ptr<Property>> properties;
@@ -75,6 +199,71 @@ protected:
     bool dirty = false;
     void *data = NULL;
 
+    /**
+     * @brief Locks the metrics of the owner while the metric is changed. Every change that marks the metric dirty is made under this lock.
+     *
+     * @return MetricLock
+     */
+    MetricLock lockOwner()
+    {
+        return MetricLock(owner);
+    };
+    /**
+     * @brief Marks the metric as dirty. The owner of the metric is notified the first time the metric becomes dirty after being published.
+     * Must be called while the owner is locked.
+     */
+    void markDirty();
+    /**
+     * @brief Notifies the owner of the metric that a change is being held back until it can be published,
+     * so the owner checks the metric again with checkHeld. The owner is only notified once until the change is released.
+     */
+    void hold();
+    /**
+     * @brief Marks a held change as dirty once it can be published
+     *
+     * @param now The current time
+     * @return int32_t the time in milliseconds before the change can be published, 0 if nothing is held any longer
+     */
+    virtual int32_t releaseHeld(time_t now);
+    /**
+     * @brief Records the current value into the history buffer before it is replaced by a new value.
+     * Only unpublished values are recorded. If the buffer is full the oldest sample is discarded.
+     */
+    void recordHistory();
+    /**
+     * @brief Adds the buffered values to a protobuf payload as historical metrics, oldest first.
+     *
+     * @param payload A protobuf payload that the buffered values will be added to
+     */
+    void addHistoryToPayload(org_eclipse_tahu_protobuf_Payload *payload);
+    /**
+     * @brief Construct a new Sparkplug Metric whose value is stored by the derived class.
+     * The derived class is responsible for pointing data at its storage.
+     *
+     * @param name The name of the Sparkplug Metric
+     * @param size The memory size of the value
+     * @param dataType Sparkplug Datatype
+     */
+    Metric(const char *name, size_t size, uint8_t dataType);
+    /**
+     * @brief Initializes a protobuf metric with a copy of the current value, which is released along with the payload by free_payload
+     *
+     * @param metric The protobuf metric
+     * @param metricName The name of the metric, or NULL if only the alias is sent
+     * @param isBirth If the metric is a part of a birth message
+     * @return int 0 on success
+     */
+    virtual int initPayloadMetric(org_eclipse_tahu_protobuf_Payload_Metric *metric, const char *metricName, bool isBirth);
+    /**
+     * @brief Writes the value field of a protobuf metric straight from a value
+     *
+     * @param stream The stream the metric is written to
+     * @param value The value of the metric
+     * @param isBirth If the metric is a part of a birth message
+     * @return true if the value was written
+     */
+    virtual bool encodeValue(pb_ostream_t *stream, void *value, bool isBirth);
+
 public:
     /**
      * @brief Construct a new Sparkplug Metric
@@ -98,6 +287,24 @@ public:
      * @param isBirth If the payload is a part of a birth message
      */
     void addToPayload(org_eclipse_tahu_protobuf_Payload *payload, bool isBirth = false);
+    /**
+     * @brief Encodes the metric into the stream of a payload, writing its protobuf fields straight from its value, history and properties.
+     * No struct form of the metric is built. Only dirty metrics are encoded outside of a birth.
+     *
+     * @param stream The stream of the payload the metric is written to
+     * @param isBirth If the payload is a part of a birth message
+     * @return int 0 on success, -1 if the metric could not be encoded
+     */
+    int encode(pb_ostream_t *stream, bool isBirth = false);
+    /**
+     * @brief Appends the metric to an encoded birth payload. With the birth cache enabled the encoded metric is kept between births,
+     * and is only encoded again once the value or properties of the metric have changed, so only the timestamp is written for every birth.
+     *
+     * @param buffer The encoded payload the metric is appended to
+     * @param timestamp The timestamp of the birth
+     * @return int 0 on success, -1 if the metric could not be encoded
+     */
+    int appendBirth(std::vector<uint8_t> &buffer, uint64_t timestamp);
     /**
      * @brief Sets a new value of the metric
      *
@@ -115,7 +322,7 @@ public:
      * @brief Used to mark the metric that is had been published
      *
      */
-    void published();
+    virtual void published();
     /**
      * @brief Returns the pointer to the metric data
      *
@@ -128,6 +335,69 @@ public:
      * @return void*
      */
     const char *getName();
+    /**
+     * @brief Returns the Sparkplug alias of the metric. An alias of 0 means the metric has no alias.
+     *
+     * @return uint64_t
+     */
+    uint64_t getAlias();
+    /**
+     * @brief Sets the Sparkplug alias of the metric.
+     * Metrics with an alias are published with their name and alias in births, and only their alias in data messages.
+     * The alias must be set before the metric is added to a Publishable.
+     *
+     * @param alias The alias of the metric, 0 to remove the alias
+     */
+    void setAlias(uint64_t alias);
+    /**
+     * @brief Sets the owner of the metric that will be notified when the metric becomes dirty.
+     *
+     * @param owner
+     */
+    void setOwner(MetricOwner *owner);
+    /**
+     * @brief Returns the owner of the metric that is notified when the metric becomes dirty.
+     *
+     * @return MetricOwner*
+     */
+    MetricOwner *getOwner();
+    /**
+     * @brief Link used by the owner to keep an intrusive list of dirty metrics.
+     *
+     * @return Metric*
+     */
+    Metric *getNextDirty();
+    /**
+     * @brief Sets the link used by the owner to keep an intrusive list of dirty metrics.
+     *
+     * @param metric
+     */
+    void setNextDirty(Metric *metric);
+    /**
+     * @brief Used by the owner to check a metric that is holding back a change, publishing the change once it can be published.
+     *
+     * @param now The current time
+     * @return int32_t the time in milliseconds before the metric needs to be checked again, 0 if nothing is held any longer
+     */
+    int32_t checkHeld(time_t now);
+    /**
+     * @brief Enables buffering of values that are replaced before the metric is published.
+     * Buffered values are published in the next data message as historical metrics, along with the current value.
+     * Only supported on metrics with a fixed size value.
+     *
+     * @param samples The maximum number of buffered values, 0 to disable buffering
+     * @return int 0 on success, -1 if the buffer could not be allocated
+     */
+    int enableHistory(size_t samples);
+    /**
+     * @brief Enables keeping the birth encoding of the metric, along with a copy of its value, between births.
+     * Trades memory for faster rebirths of metrics that rarely change. Not supported on DataSet metrics,
+     * whose values are large and change with every row.
+     *
+     * @param enabled Whether births are cached
+     * @return int 0 on success, -1 if the metric does not support a birth cache
+     */
+    int enableBirthCache(bool enabled);
 
     /**
      * @brief Fired when a command is received for this Metric.
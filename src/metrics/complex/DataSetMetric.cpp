@@ -0,0 +1,566 @@
+/*
+ * File: DataSetMetric.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "DataSetMetric.h"
+#include "utils/Protobuf.h"
+#include <functional>
+#include <limits>
+#include <pb_encode.h>
+
+#ifdef DEBUGGING
+#define LOGGER(format, ...)    \
+    printf("DataSetMetric: "); \
+    printf(format, ##__VA_ARGS__)
+#else
+#define LOGGER(out, ...)
+#endif
+
+// Slack allowed in the text buffer of a column before replaced strings are compacted away
+#define DATASET_TEXT_SLACK 1024
+
+/**
+ * @brief Whether a DataSet data type is stored as a string
+ *
+ */
+static bool isStringType(uint32_t type)
+{
+    return type == DATA_SET_DATA_TYPE_STRING || type == DATA_SET_DATA_TYPE_TEXT;
+}
+
+/**
+ * @brief Returns the width of a DataSet data type stored as a number, 0 for other types
+ *
+ */
+static size_t getNumberWidth(uint32_t type)
+{
+    switch (type)
+    {
+    case DATA_SET_DATA_TYPE_INT8:
+    case DATA_SET_DATA_TYPE_UINT8:
+        return sizeof(int8_t);
+    case DATA_SET_DATA_TYPE_BOOLEAN:
+        return sizeof(bool);
+    case DATA_SET_DATA_TYPE_INT16:
+    case DATA_SET_DATA_TYPE_UINT16:
+        return sizeof(int16_t);
+    case DATA_SET_DATA_TYPE_INT32:
+    case DATA_SET_DATA_TYPE_UINT32:
+        return sizeof(int32_t);
+    case DATA_SET_DATA_TYPE_FLOAT:
+        return sizeof(float);
+    case DATA_SET_DATA_TYPE_INT64:
+    case DATA_SET_DATA_TYPE_UINT64:
+    case DATA_SET_DATA_TYPE_DATETIME:
+        return sizeof(int64_t);
+    case DATA_SET_DATA_TYPE_DOUBLE:
+        return sizeof(double);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Returns the DataSetValue field a DataSet data type is written as
+ *
+ */
+static pb_size_t getValueTag(uint32_t type)
+{
+    switch (type)
+    {
+    case DATA_SET_DATA_TYPE_INT64:
+    case DATA_SET_DATA_TYPE_UINT64:
+    case DATA_SET_DATA_TYPE_DATETIME:
+        return org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue_long_value_tag;
+    case DATA_SET_DATA_TYPE_FLOAT:
+        return org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue_float_value_tag;
+    case DATA_SET_DATA_TYPE_DOUBLE:
+        return org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue_double_value_tag;
+    case DATA_SET_DATA_TYPE_BOOLEAN:
+        return org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue_boolean_value_tag;
+    case DATA_SET_DATA_TYPE_STRING:
+    case DATA_SET_DATA_TYPE_TEXT:
+        return org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue_string_value_tag;
+    default:
+        return org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue_int_value_tag;
+    }
+}
+
+/**
+ * @brief Returns the varint a cell of an integer or boolean column is written as.
+ * Types up to 32 bits are written as the uint32 int_value, like Sparkplug integer metrics.
+ *
+ */
+static uint64_t getVarint(uint32_t type, const uint8_t *cell)
+{
+    switch (type)
+    {
+    case DATA_SET_DATA_TYPE_INT8:
+        return (uint32_t)(*(int8_t *)cell);
+    case DATA_SET_DATA_TYPE_INT16:
+        return (uint32_t)(*(int16_t *)cell);
+    case DATA_SET_DATA_TYPE_INT32:
+        return (uint32_t)(*(int32_t *)cell);
+    case DATA_SET_DATA_TYPE_UINT8:
+        return *(uint8_t *)cell;
+    case DATA_SET_DATA_TYPE_UINT16:
+        return *(uint16_t *)cell;
+    case DATA_SET_DATA_TYPE_UINT32:
+        return *(uint32_t *)cell;
+    case DATA_SET_DATA_TYPE_BOOLEAN:
+        return *(bool *)cell;
+    default:
+        return *(uint64_t *)cell;
+    }
+}
+
+/**
+ * @brief Allocates a zeroed array on the heap, released along with the payload
+ *
+ */
+template <typename T>
+static T *allocateArray(size_t count)
+{
+    if (count == 0)
+    {
+        return NULL;
+    }
+    return (T *)calloc(count, sizeof(T));
+}
+
+DataSetMetric::DataSetMetric(const char *name, const std::vector<DataSetColumn> &columns) : Metric(name, sizeof(version), METRIC_DATA_TYPE_DATASET)
+{
+    data = &version;
+
+    this->columns.reserve(columns.size());
+    for (auto &column : columns)
+    {
+        size_t width = isStringType(column.type) ? sizeof(StringValue) : getNumberWidth(column.type);
+        this->columns.push_back({column.name, column.type, width, {}, std::vector<char>(1, '\0'), 0});
+    }
+}
+
+std::shared_ptr<DataSetMetric> DataSetMetric::create(const char *name, const std::vector<DataSetColumn> &columns)
+{
+    for (auto &column : columns)
+    {
+        if (!isStringType(column.type) && getNumberWidth(column.type) == 0)
+        {
+            LOGGER("Unsupported column type %u\n", column.type);
+            return nullptr;
+        }
+    }
+    return std::shared_ptr<DataSetMetric>(new DataSetMetric(name, columns));
+}
+
+bool DataSetMetric::isStringColumn(size_t column)
+{
+    return isStringType(columns[column].type);
+}
+
+void DataSetMetric::storeString(size_t row, size_t column, std::string_view value)
+{
+    Column &target = columns[column];
+    StringValue *current = (StringValue *)(target.values.data() + row * target.width);
+
+    std::less_equal<const char *> lessEqual;
+    if (!value.empty() && lessEqual(target.text.data(), value.data()) && lessEqual(value.data(), target.text.data() + target.text.size()))
+    {
+        // The value points into the text of the column, such as a string read from another row,
+        // which is moved when the text grows or is compacted
+        std::string copy(value);
+        storeString(row, column, copy);
+        return;
+    }
+
+    if (value.size() <= current->length)
+    {
+        memcpy(target.text.data() + current->offset, value.data(), value.size());
+        target.text[current->offset + value.size()] = '\0';
+        target.textUsed -= current->length - value.size();
+        current->length = value.size();
+        return;
+    }
+
+    target.textUsed += value.size() - current->length;
+    current->offset = target.text.size();
+    current->length = value.size();
+    target.text.insert(target.text.end(), value.begin(), value.end());
+    target.text.push_back('\0');
+
+    if (target.text.size() > 2 * (target.textUsed + rowCount) + DATASET_TEXT_SLACK)
+    {
+        compactText(column);
+    }
+}
+
+void DataSetMetric::compactText(size_t column)
+{
+    Column &target = columns[column];
+    std::vector<char> text(1, '\0');
+    text.reserve(target.textUsed + rowCount + 1);
+
+    for (size_t row = 0; row < rowCount; row++)
+    {
+        StringValue *value = (StringValue *)(target.values.data() + row * target.width);
+
+        if (value->length == 0)
+        {
+            value->offset = 0;
+            continue;
+        }
+
+        const char *start = target.text.data() + value->offset;
+        value->offset = text.size();
+        text.insert(text.end(), start, start + value->length + 1);
+    }
+
+    target.text.swap(text);
+}
+
+void DataSetMetric::addRow()
+{
+    for (auto &column : columns)
+    {
+        column.values.resize(column.values.size() + column.width);
+    }
+    dirtyRows.push_back(false);
+    rowCount++;
+}
+
+void DataSetMetric::rowChanged(size_t row)
+{
+    if (!dirtyRows[row])
+    {
+        dirtyRows[row] = true;
+        dirtyRowCount++;
+    }
+    version++;
+    changedTime = TimeManager::getTime();
+    markDirty();
+}
+
+const char *DataSetMetric::getString(size_t row, size_t column)
+{
+    if (row >= rowCount || column >= columns.size() || !isStringColumn(column))
+    {
+        return NULL;
+    }
+
+    const Column &source = columns[column];
+    return source.text.data() + ((StringValue *)(source.values.data() + row * source.width))->offset;
+}
+
+void DataSetMetric::clear()
+{
+    MetricLock lock = lockOwner();
+
+    for (auto &column : columns)
+    {
+        column.values.clear();
+        column.text.assign(1, '\0');
+        column.textUsed = 0;
+    }
+    rowCount = 0;
+    dirtyRows.clear();
+    dirtyRowCount = 0;
+    version++;
+    changedTime = TimeManager::getTime();
+    markDirty();
+}
+
+size_t DataSetMetric::getRowCount()
+{
+    return rowCount;
+}
+
+size_t DataSetMetric::getColumnCount()
+{
+    return columns.size();
+}
+
+bool DataSetMetric::isRowDirty(size_t row)
+{
+    return row < rowCount && dirtyRows[row];
+}
+
+size_t DataSetMetric::getDirtyRowCount()
+{
+    return dirtyRowCount;
+}
+
+void DataSetMetric::published()
+{
+    Metric::published();
+
+    if (dirtyRowCount > 0)
+    {
+        dirtyRows.assign(rowCount, false);
+        dirtyRowCount = 0;
+    }
+}
+
+size_t DataSetMetric::getCellSize(const Column &column, size_t row)
+{
+    const uint8_t *cell = column.values.data() + row * column.width;
+
+    switch (column.type)
+    {
+    case DATA_SET_DATA_TYPE_FLOAT:
+        return 1 + sizeof(float);
+    case DATA_SET_DATA_TYPE_DOUBLE:
+        return 1 + sizeof(double);
+    case DATA_SET_DATA_TYPE_STRING:
+    case DATA_SET_DATA_TYPE_TEXT:
+    {
+        uint32_t length = ((StringValue *)cell)->length;
+        return 1 + protobufVarintSize(length) + length;
+    }
+    default:
+        return 1 + protobufVarintSize(getVarint(column.type, cell));
+    }
+}
+
+size_t DataSetMetric::getRowSize(size_t row)
+{
+    size_t size = 0;
+    for (auto &column : columns)
+    {
+        size_t cellSize = getCellSize(column, row);
+        size += 1 + protobufVarintSize(cellSize) + cellSize;
+    }
+    return size;
+}
+
+size_t DataSetMetric::getEncodedSize()
+{
+    size_t size = 1 + protobufVarintSize(columns.size());
+
+    for (auto &column : columns)
+    {
+        size += 1 + protobufVarintSize(column.name.size()) + column.name.size();
+        size += 1 + protobufVarintSize(column.type);
+    }
+
+    for (size_t row = 0; row < rowCount; row++)
+    {
+        size_t rowSize = getRowSize(row);
+        size += 1 + protobufVarintSize(rowSize) + rowSize;
+    }
+
+    return size;
+}
+
+bool DataSetMetric::encodeCell(pb_ostream_t *stream, const Column &column, size_t row)
+{
+    const uint8_t *cell = column.values.data() + row * column.width;
+    pb_size_t tag = getValueTag(column.type);
+
+    switch (column.type)
+    {
+    case DATA_SET_DATA_TYPE_FLOAT:
+        return pb_encode_tag(stream, PB_WT_32BIT, tag) && pb_encode_fixed32(stream, cell);
+    case DATA_SET_DATA_TYPE_DOUBLE:
+        return pb_encode_tag(stream, PB_WT_64BIT, tag) && pb_encode_fixed64(stream, cell);
+    case DATA_SET_DATA_TYPE_STRING:
+    case DATA_SET_DATA_TYPE_TEXT:
+    {
+        const StringValue *value = (const StringValue *)cell;
+        return pb_encode_tag(stream, PB_WT_STRING, tag) &&
+               pb_encode_string(stream, (const pb_byte_t *)column.text.data() + value->offset, value->length);
+    }
+    default:
+        return pb_encode_tag(stream, PB_WT_VARINT, tag) && pb_encode_varint(stream, getVarint(column.type, cell));
+    }
+}
+
+bool DataSetMetric::encodeValue(pb_ostream_t *stream, __attribute__((unused)) void *value, __attribute__((unused)) bool isBirth)
+{
+    size_t length = getEncodedSize();
+
+    if (!pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_Metric_dataset_value_tag) ||
+        !pb_encode_varint(stream, length))
+    {
+        return false;
+    }
+
+    // Sizing streams only need the length, which is known without walking the cells
+    if (stream->callback == NULL)
+    {
+        return pb_write(stream, NULL, length);
+    }
+
+    // Fields are written in field number order, as nanopb would encode the struct form
+    if (!pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_DataSet_num_of_columns_tag) ||
+        !pb_encode_varint(stream, columns.size()))
+    {
+        return false;
+    }
+
+    for (auto &column : columns)
+    {
+        if (!pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_DataSet_columns_tag) ||
+            !pb_encode_string(stream, (const pb_byte_t *)column.name.data(), column.name.size()))
+        {
+            return false;
+        }
+    }
+
+    for (auto &column : columns)
+    {
+        if (!pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_DataSet_types_tag) ||
+            !pb_encode_varint(stream, column.type))
+        {
+            return false;
+        }
+    }
+
+    for (size_t row = 0; row < rowCount; row++)
+    {
+        if (!pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_DataSet_rows_tag) ||
+            !pb_encode_varint(stream, getRowSize(row)))
+        {
+            return false;
+        }
+
+        for (auto &column : columns)
+        {
+            if (!pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_DataSet_Row_elements_tag) ||
+                !pb_encode_varint(stream, getCellSize(column, row)) ||
+                !encodeCell(stream, column, row))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool DataSetMetric::buildDataSet(org_eclipse_tahu_protobuf_Payload_DataSet *dataSet)
+{
+    memset(dataSet, 0, sizeof(org_eclipse_tahu_protobuf_Payload_DataSet));
+
+    if (columns.size() > std::numeric_limits<pb_size_t>::max() || rowCount > std::numeric_limits<pb_size_t>::max())
+    {
+        LOGGER("%s has too many rows or columns for the struct form\n", getName());
+        return false;
+    }
+
+    dataSet->has_num_of_columns = true;
+    dataSet->num_of_columns = columns.size();
+    dataSet->columns = allocateArray<char *>(columns.size());
+    dataSet->types = allocateArray<uint32_t>(columns.size());
+    dataSet->rows = allocateArray<org_eclipse_tahu_protobuf_Payload_DataSet_Row>(rowCount);
+
+    if ((columns.size() > 0 && (dataSet->columns == NULL || dataSet->types == NULL)) || (rowCount > 0 && dataSet->rows == NULL))
+    {
+        return false;
+    }
+
+    for (auto &column : columns)
+    {
+        char *name = strdup(column.name.c_str());
+        if (name == NULL)
+        {
+            return false;
+        }
+        dataSet->columns[dataSet->columns_count++] = name;
+        dataSet->types[dataSet->types_count++] = column.type;
+    }
+
+    for (size_t row = 0; row < rowCount; row++)
+    {
+        org_eclipse_tahu_protobuf_Payload_DataSet_Row *target = &dataSet->rows[dataSet->rows_count++];
+        target->elements = allocateArray<org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue>(columns.size());
+
+        if (columns.size() > 0 && target->elements == NULL)
+        {
+            return false;
+        }
+
+        for (auto &column : columns)
+        {
+            const uint8_t *cell = column.values.data() + row * column.width;
+            org_eclipse_tahu_protobuf_Payload_DataSet_DataSetValue *element = &target->elements[target->elements_count++];
+            element->which_value = getValueTag(column.type);
+
+            switch (column.type)
+            {
+            case DATA_SET_DATA_TYPE_FLOAT:
+                element->value.float_value = *(float *)cell;
+                break;
+            case DATA_SET_DATA_TYPE_DOUBLE:
+                element->value.double_value = *(double *)cell;
+                break;
+            case DATA_SET_DATA_TYPE_BOOLEAN:
+                element->value.boolean_value = *(bool *)cell;
+                break;
+            case DATA_SET_DATA_TYPE_STRING:
+            case DATA_SET_DATA_TYPE_TEXT:
+            {
+                const char *text = column.text.data() + ((StringValue *)cell)->offset;
+                element->value.string_value = strdup(text);
+                if (element->value.string_value == NULL)
+                {
+                    return false;
+                }
+                break;
+            }
+            case DATA_SET_DATA_TYPE_INT64:
+            case DATA_SET_DATA_TYPE_UINT64:
+            case DATA_SET_DATA_TYPE_DATETIME:
+                element->value.long_value = getVarint(column.type, cell);
+                break;
+            default:
+                element->value.int_value = (uint32_t)getVarint(column.type, cell);
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+int DataSetMetric::initPayloadMetric(org_eclipse_tahu_protobuf_Payload_Metric *metric, const char *metricName, __attribute__((unused)) bool isBirth)
+{
+    org_eclipse_tahu_protobuf_Payload_DataSet dataSet;
+
+    if (!buildDataSet(&dataSet))
+    {
+        pb_release(org_eclipse_tahu_protobuf_Payload_DataSet_fields, &dataSet);
+        init_metric(metric, metricName, getAlias() != 0, getAlias(), METRIC_DATA_TYPE_DATASET, false, false, NULL, 0);
+        return -1;
+    }
+
+    // The heap allocated DataSet is moved into the metric, and released with the payload
+    return init_metric(metric, metricName, getAlias() != 0, getAlias(), METRIC_DATA_TYPE_DATASET, false, false, &dataSet, sizeof(dataSet));
+}
+
@@ -0,0 +1,455 @@
+/*
+ * File: DataSetMetric.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_METRICS_COMPLEX_DATASETMETRIC
+#define SRC_METRICS_COMPLEX_DATASETMETRIC
+
+#include "../Metric.h"
+#include <stdint.h>
+#include <tahu.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief The name and Sparkplug DataSet data type of a DataSet column
+ *
+ */
+struct DataSetColumn
+{
+    std::string name;
+    uint32_t type;
+};
+
+/**
+ * @brief DataSet Metric implementation.
+ * Rows are stored column by column, with the values of each column kept in one contiguous buffer.
+ * Every birth and data message carries the full table, as Sparkplug hosts replace their copy of a DataSet with each value.
+ * Changed rows only decide whether the DataSet is published.
+ *
+ * Births and data payloads are streamed straight from the columns, without allocating per row or cell.
+ * Only the streaming path avoids those allocations: addToPayload builds the struct form on the heap,
+ * with a copy of every column name and string cell.
+ *
+ */
+class DataSetMetric : public Metric
+{
+private:
+    /**
+     * @brief A string value, stored NUL terminated in the text buffer of its column
+     *
+     */
+    struct StringValue
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    /**
+     * @brief The values of a column. Fixed width values are stored in place, string columns store a StringValue per row.
+     * Offset 0 of the text buffer holds the empty string.
+     *
+     */
+    struct Column
+    {
+        std::string name;
+        uint32_t type;
+        size_t width;
+        std::vector<uint8_t> values;
+        std::vector<char> text;
+        size_t textUsed;
+    };
+
+    std::vector<Column> columns;
+    size_t rowCount = 0;
+    std::vector<bool> dirtyRows;
+    size_t dirtyRowCount = 0;
+    // Stored as the value of the metric so it is never sent as null, and changed with every row
+    uint64_t version = 0;
+
+    /**
+     * @brief Construct a new DataSet Sparkplug Metric
+     *
+     * @param name The name of the Sparkplug Metric
+     * @param columns The columns of the DataSet
+     */
+    DataSetMetric(const char *name, const std::vector<DataSetColumn> &columns);
+
+    /**
+     * @brief Whether a column stores strings
+     *
+     * @param column
+     * @return true
+     * @return false
+     */
+    bool isStringColumn(size_t column);
+    /**
+     * @brief Whether a value of type T can be stored in a column
+     *
+     * @tparam T
+     * @param column
+     * @return true
+     * @return false
+     */
+    template <typename T>
+    bool accepts(size_t column)
+    {
+        if (column >= columns.size())
+        {
+            return false;
+        }
+        if constexpr (std::is_arithmetic<T>::value)
+        {
+            return !isStringColumn(column);
+        }
+        else
+        {
+            return std::is_convertible<const T &, std::string_view>::value && isStringColumn(column);
+        }
+    }
+    /**
+     * @brief Whether a row of values can be stored, one value per column
+     *
+     * @tparam T
+     * @return true
+     * @return false
+     */
+    template <typename... T>
+    bool acceptsRow()
+    {
+        size_t column = 0;
+        bool accepted = sizeof...(T) == columns.size();
+        ((accepted = accepted && accepts<T>(column++)), ...);
+        return accepted;
+    }
+    /**
+     * @brief Converts a number to the type of a column and stores it
+     *
+     * @tparam T
+     * @param row
+     * @param column
+     * @param value
+     */
+    template <typename T>
+    void storeNumber(size_t row, size_t column, T value)
+    {
+        Column &target = columns[column];
+        uint8_t *cell = target.values.data() + row * target.width;
+
+        switch (target.type)
+        {
+        case DATA_SET_DATA_TYPE_INT8:
+            *(int8_t *)cell = (int8_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_INT16:
+            *(int16_t *)cell = (int16_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_INT32:
+            *(int32_t *)cell = (int32_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_INT64:
+            *(int64_t *)cell = (int64_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_UINT8:
+            *(uint8_t *)cell = (uint8_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_UINT16:
+            *(uint16_t *)cell = (uint16_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_UINT32:
+            *(uint32_t *)cell = (uint32_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_UINT64:
+        case DATA_SET_DATA_TYPE_DATETIME:
+            *(uint64_t *)cell = (uint64_t)value;
+            break;
+        case DATA_SET_DATA_TYPE_FLOAT:
+            *(float *)cell = (float)value;
+            break;
+        case DATA_SET_DATA_TYPE_DOUBLE:
+            *(double *)cell = (double)value;
+            break;
+        case DATA_SET_DATA_TYPE_BOOLEAN:
+            *(bool *)cell = (bool)value;
+            break;
+        }
+    }
+    /**
+     * @brief Stores a string in the text buffer of a column, reusing the space of the previous value when it fits.
+     * Values that point into the text of the column are copied before they are stored.
+     *
+     * @param row
+     * @param column
+     * @param value
+     */
+    void storeString(size_t row, size_t column, std::string_view value);
+    /**
+     * @brief Stores a value that has been checked with accepts
+     *
+     * @tparam T
+     * @param row
+     * @param column
+     * @param value
+     */
+    template <typename T>
+    void storeValue(size_t row, size_t column, const T &value)
+    {
+        if constexpr (std::is_arithmetic<T>::value)
+        {
+            storeNumber(row, column, value);
+        }
+        else
+        {
+            storeString(row, column, std::string_view(value));
+        }
+    }
+    /**
+     * @brief Adds a row holding zero values and empty strings
+     *
+     */
+    void addRow();
+    /**
+     * @brief Marks a row as changed, and the metric as dirty
+     *
+     * @param row
+     */
+    void rowChanged(size_t row);
+    /**
+     * @brief Moves the strings of a column into a new text buffer, dropping the space of replaced values
+     *
+     * @param column
+     */
+    void compactText(size_t column);
+
+    /**
+     * @brief Returns the encoded size of the DataSetValue of a cell
+     *
+     * @param column
+     * @param row
+     * @return size_t
+     */
+    size_t getCellSize(const Column &column, size_t row);
+    /**
+     * @brief Returns the encoded size of the elements of a row
+     *
+     * @param row
+     * @return size_t
+     */
+    size_t getRowSize(size_t row);
+    /**
+     * @brief Returns the encoded size of the DataSet
+     *
+     * @return size_t
+     */
+    size_t getEncodedSize();
+    /**
+     * @brief Writes the value field of the DataSetValue of a cell
+     *
+     * @param stream
+     * @param column
+     * @param row
+     * @return true if the value was written
+     */
+    bool encodeCell(pb_ostream_t *stream, const Column &column, size_t row);
+    /**
+     * @brief Builds the struct form of the DataSet as a copy allocated on the heap, released with pb_release.
+     * Every column name and string cell is duplicated, so the struct form costs an allocation per string.
+     *
+     * @param dataSet The DataSet that is built
+     * @return true if the DataSet was built
+     */
+    bool buildDataSet(org_eclipse_tahu_protobuf_Payload_DataSet *dataSet);
+
+protected:
+    int initPayloadMetric(org_eclipse_tahu_protobuf_Payload_Metric *metric, const char *metricName, bool isBirth) override;
+    bool encodeValue(pb_ostream_t *stream, void *value, bool isBirth) override;
+
+public:
+    /**
+     * @brief Construct a new DataSet Sparkplug Metric shared pointer
+     *
+     * @param name The name of the Sparkplug Metric
+     * @param columns The name and DATA_SET_DATA_TYPE of each column
+     * @return std::shared_ptr<DataSetMetric> The metric, or nullptr if a column has an unknown data type
+     */
+    static std::shared_ptr<DataSetMetric> create(const char *name, const std::vector<DataSetColumn> &columns);
+
+    /**
+     * @brief Appends a row to the DataSet, with one value per column.
+     * Numbers are converted to the type of their column, strings are only accepted by STRING and TEXT columns.
+     *
+     * @tparam T
+     * @param values
+     * @return int 0 on success, -1 if the values do not match the columns
+     */
+    template <typename... T>
+    int appendRow(const T &...values)
+    {
+        if (!acceptsRow<T...>())
+        {
+            return -1;
+        }
+
+        MetricLock lock = lockOwner();
+        addRow();
+        size_t column = 0;
+        (storeValue(rowCount - 1, column++, values), ...);
+        rowChanged(rowCount - 1);
+        return 0;
+    }
+    /**
+     * @brief Replaces the values of a row, with one value per column
+     *
+     * @tparam T
+     * @param row
+     * @param values
+     * @return int 0 on success, -1 if the row does not exist or the values do not match the columns
+     */
+    template <typename... T>
+    int replaceRow(size_t row, const T &...values)
+    {
+        if (row >= rowCount || !acceptsRow<T...>())
+        {
+            return -1;
+        }
+
+        MetricLock lock = lockOwner();
+        size_t column = 0;
+        (storeValue(row, column++, values), ...);
+        rowChanged(row);
+        return 0;
+    }
+    /**
+     * @brief Sets a single value of a row
+     *
+     * @tparam T
+     * @param row
+     * @param column
+     * @param value
+     * @return int 0 on success, -1 if the cell does not exist or the value does not match the column
+     */
+    template <typename T>
+    int setCell(size_t row, size_t column, const T &value)
+    {
+        if (row >= rowCount || !accepts<T>(column))
+        {
+            return -1;
+        }
+
+        MetricLock lock = lockOwner();
+        storeValue(row, column, value);
+        rowChanged(row);
+        return 0;
+    }
+    /**
+     * @brief Returns a number stored in the DataSet, converted to T
+     *
+     * @tparam T
+     * @param row
+     * @param column
+     * @return T The value, or 0 if the cell does not exist or holds a string
+     */
+    template <typename T>
+    T getCell(size_t row, size_t column)
+    {
+        if (row >= rowCount || !accepts<T>(column))
+        {
+            return T();
+        }
+
+        const uint8_t *cell = columns[column].values.data() + row * columns[column].width;
+
+        switch (columns[column].type)
+        {
+        case DATA_SET_DATA_TYPE_INT8:
+            return (T)(*(int8_t *)cell);
+        case DATA_SET_DATA_TYPE_INT16:
+            return (T)(*(int16_t *)cell);
+        case DATA_SET_DATA_TYPE_INT32:
+            return (T)(*(int32_t *)cell);
+        case DATA_SET_DATA_TYPE_INT64:
+            return (T)(*(int64_t *)cell);
+        case DATA_SET_DATA_TYPE_UINT8:
+            return (T)(*(uint8_t *)cell);
+        case DATA_SET_DATA_TYPE_UINT16:
+            return (T)(*(uint16_t *)cell);
+        case DATA_SET_DATA_TYPE_UINT32:
+            return (T)(*(uint32_t *)cell);
+        case DATA_SET_DATA_TYPE_FLOAT:
+            return (T)(*(float *)cell);
+        case DATA_SET_DATA_TYPE_DOUBLE:
+            return (T)(*(double *)cell);
+        case DATA_SET_DATA_TYPE_BOOLEAN:
+            return (T)(*(bool *)cell);
+        default:
+            return (T)(*(uint64_t *)cell);
+        }
+    }
+    /**
+     * @brief Returns a string stored in the DataSet. The string is valid until the cell or column is changed.
+     *
+     * @param row
+     * @param column
+     * @return const char* The string, or NULL if the cell does not exist or holds a number
+     */
+    const char *getString(size_t row, size_t column);
+    /**
+     * @brief Removes every row from the DataSet
+     *
+     */
+    void clear();
+
+    size_t getRowCount();
+    size_t getColumnCount();
+    /**
+     * @brief Whether a row has been appended or replaced since the metric was last published
+     *
+     * @param row
+     * @return true
+     * @return false
+     */
+    bool isRowDirty(size_t row);
+    /**
+     * @brief Returns the number of rows appended or replaced since the metric was last published
+     *
+     * @return size_t
+     */
+    size_t getDirtyRowCount();
+    /**
+     * @brief Used to mark the metric and its rows as published
+     *
+     */
+    void published() override;
+};
+
+#endif /* SRC_METRICS_COMPLEX_DATASETMETRIC */
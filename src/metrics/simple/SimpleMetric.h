@@ -33,7 +33,82 @@
 #define SRC_METRICS_SIMPLE_SIMPLEMETRIC
 
 #include "../Metric.h"
+#include <cmath>
 #include <memory>
+#include <type_traits>
+
+/**
+ * @brief Storage for the value of a SimpleMetric.
+ * Fixed width values are stored inline within the metric, other types are left to the Metric's heap storage.
+ */
+template <typename T, bool = std::is_trivially_copyable<T>::value>
+struct SimpleMetricStorage
+{
+};
+
+template <typename T>
+struct SimpleMetricStorage<T, true>
+{
+    T value;
+};
+
+/**
+ * @brief Report by exception settings for a SimpleMetric, allocated once a deadband or minimum interval is set.
+ * Only numeric values support deadbands, other types are reported on any change.
+ */
+template <typename T, bool = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>
+struct SimpleMetricDeadband
+{
+};
+
+template <typename T>
+struct SimpleMetricDeadband<T, true>
+{
+    double absolute = 0;
+    double percent = 0;
+    time_t minimumInterval = 0;
+    T reported;
+    time_t reportedTime = 0;
+
+    /**
+     * @brief Whether the minimum interval has not yet passed since the last report
+     *
+     * @param time The current time
+     * @return true
+     * @return false
+     */
+    bool isWithinInterval(time_t time)
+    {
+        return time - reportedTime < minimumInterval;
+    }
+
+    /**
+     * @brief Whether a value has moved far enough from the last reported value to be published.
+     * Every configured deadband must be exceeded, and the minimum interval must have passed since the last report.
+     *
+     * @param value The new value
+     * @param time The current time
+     * @return true The change is significant
+     * @return false The change is within the deadband
+     */
+    bool isSignificant(T value, time_t time)
+    {
+        if (isWithinInterval(time))
+        {
+            return false;
+        }
+
+        double difference = std::fabs((double)value - (double)reported);
+
+        // Changes to or from NaN are always significant
+        if (difference != difference)
+        {
+            return (value != value) != (reported != reported);
+        }
+
+        return difference > absolute && difference > std::fabs((double)reported) * percent / 100.0;
+    }
+};
 
 /**
  * @brief Simple Metric implementation.
@@ -44,6 +119,120 @@ template <typename T>
 class SimpleMetric : public Metric
 {
 private:
+    static constexpr bool isInline = std::is_trivially_copyable<T>::value;
+    static constexpr bool hasDeadband = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+
+    [[no_unique_address]] SimpleMetricStorage<T> storage;
+    [[no_unique_address]] std::conditional_t<hasDeadband, std::unique_ptr<SimpleMetricDeadband<T>>, SimpleMetricDeadband<T>> deadband;
+
+    /**
+     * @brief Returns the deadband settings of the metric, allocating them on first use
+     *
+     * @return SimpleMetricDeadband<T>&
+     */
+    SimpleMetricDeadband<T> &getDeadband() requires(hasDeadband)
+    {
+        if (deadband == nullptr)
+        {
+            deadband = std::make_unique<SimpleMetricDeadband<T>>();
+            deadband->reported = storage.value;
+        }
+        return *deadband;
+    };
+
+    /**
+     * @brief Whether the stored value differs from the last published value due to a suppressed change
+     *
+     * @return true
+     * @return false
+     */
+    bool hasUnreportedChange()
+    {
+        if constexpr (hasDeadband)
+        {
+            return deadband != nullptr && deadband->reported != storage.value;
+        }
+        return false;
+    };
+
+    /**
+     * @brief Whether setting a value would leave the metric unchanged
+     *
+     * @param value The new value
+     * @return true
+     * @return false
+     */
+    bool isUnchanged(T value) requires(isInline)
+    {
+        return !dirty && storage.value == value && !hasUnreportedChange();
+    };
+
+    /**
+     * @brief Stores a new value that has already been compared against the current value
+     *
+     * @param value The new value
+     * @param time The time of the change
+     */
+    void applyValue(T value, time_t time) requires(isInline)
+    {
+        if (dirty || storage.value != value)
+        {
+            // The unpublished value is about to be replaced, keep it if history is enabled
+            if (dirty && storage.value != value)
+            {
+                recordHistory();
+            }
+            storage.value = value;
+            changedTime = time;
+        }
+
+        if constexpr (hasDeadband)
+        {
+            if (deadband != nullptr)
+            {
+                // Insignificant changes are stored, but are not published until a significant change or birth
+                if (!dirty && !deadband->isSignificant(value, time))
+                {
+                    // Changes held back by the minimum interval are checked again once the interval has passed
+                    if (deadband->isWithinInterval(time))
+                    {
+                        hold();
+                    }
+                    return;
+                }
+
+                if (!dirty)
+                {
+                    deadband->reportedTime = time;
+                }
+                deadband->reported = value;
+            }
+        }
+
+        markDirty();
+    };
+
+protected:
+    int32_t releaseHeld(time_t now) override
+    {
+        if constexpr (hasDeadband)
+        {
+            if (dirty || !hasUnreportedChange())
+            {
+                return 0;
+            }
+
+            if (deadband->isWithinInterval(now))
+            {
+                return (int32_t)(deadband->reportedTime + deadband->minimumInterval - now);
+            }
+
+            // The held value is published if it is still significant now that the interval has passed
+            applyValue(storage.value, now);
+        }
+        return 0;
+    };
+
 public:
     /**
      * @brief Construct a new Sparkplug Metric
@@ -58,7 +247,7 @@ public:
      * @param size The memory size required for the data
      * @param dataType Sparkplug Datatype
      */
-    SimpleMetric(const char *name, void *data, size_t size, uint8_t dataType) : Metric(name, data, size, dataType){};
+    SimpleMetric(const char *name, void *data, size_t size, uint8_t dataType) requires(!isInline) : Metric(name, data, size, dataType){};
     /**
      * @brief Construct a new Sparkplug Metric
      *
@@ -67,13 +256,20 @@ public:
      * @param data The piece of data that will be as the first value of the metric
      * @param dataType Sparkplug Datatype
      */
-    SimpleMetric(const char *name, T data, uint8_t dataType) : Metric(name, &data, sizeof(T), dataType){};
+    SimpleMetric(const char *name, T data, uint8_t dataType) requires(isInline) : Metric(name, sizeof(T), dataType), storage{data}
+    {
+        this->data = &storage.value;
+    };
+    SimpleMetric(const char *name, T data, uint8_t dataType) requires(!isInline) : Metric(name, &data, sizeof(T), dataType){};
 
     inline static SimpleMetric<uint8_t> create(const char *name, uint8_t value)
     {
         return SimpleMetric<uint8_t>(name, value, METRIC_DATA_TYPE_UINT8);
     }
 
+    SimpleMetric(const SimpleMetric &) = delete;
+    SimpleMetric &operator=(const SimpleMetric &) = delete;
+
     /**
      * @brief Sets a new value of the metric
      *
@@ -81,13 +277,115 @@ public:
      */
     void setValue(T value)
     {
-        Metric::setValue(&value);
+        if constexpr (isInline)
+        {
+            MetricLock lock = lockOwner();
+
+            if (isUnchanged(value))
+            {
+                return;
+            }
+
+            applyValue(value, TimeManager::getTime());
+        }
+        else
+        {
+            Metric::setValue(&value);
+        }
+    };
+
+    /**
+     * @brief Sets a new value of the metric with a time that was read by the caller.
+     * Used to update many metrics with a single read of the clock.
+     *
+     * @param value The new value
+     * @param time The time of the change
+     * @return true The value was stored
+     * @return false The value was unchanged
+     */
+    bool setValue(T value, time_t time) requires(isInline)
+    {
+        MetricLock lock = lockOwner();
+        return setValueLocked(value, time);
+    };
+
+    /**
+     * @brief Sets a new value of the metric with a time that was read by the caller, while the caller already holds the metrics lock of the owner.
+     * Used by Publishable::updateMetrics to update many metrics under a single lock.
+     *
+     * @param value The new value
+     * @param time The time of the change
+     * @return true The value was stored
+     * @return false The value was unchanged
+     */
+    bool setValueLocked(T value, time_t time) requires(isInline)
+    {
+        if (isUnchanged(value))
+        {
+            return false;
+        }
+
+        applyValue(value, time);
+        return true;
     };
 
     T &getValue()
     {
         return *(T *)data;
     };
+
+    /**
+     * @brief Sets the deadband of the metric. Changes are only published once the value has moved past every
+     * configured deadband from the last published value. A deadband of 0 publishes on any change.
+     *
+     * @param absolute The absolute change required
+     * @param percent The change required as a percentage of the last published value
+     */
+    void setDeadband(double absolute, double percent = 0) requires(hasDeadband)
+    {
+        getDeadband().absolute = absolute;
+        getDeadband().percent = percent;
+    };
+
+    /**
+     * @brief Sets the minimum time between published changes of the metric.
+     * Changes made within the interval are stored, and are published once the interval has passed.
+     *
+     * @param interval Minimum interval in milliseconds
+     */
+    void setMinimumInterval(time_t interval) requires(hasDeadband)
+    {
+        getDeadband().minimumInterval = interval;
+    };
+
+    /**
+     * @brief Marks the metric as published. Births publish the current value, so it becomes the value deadbands are measured from.
+     */
+    void published() override
+    {
+        Metric::published();
+        if constexpr (hasDeadband)
+        {
+            if (deadband != nullptr)
+            {
+                deadband->reported = storage.value;
+            }
+        }
+    };
+};
+
+/**
+ * @brief A new value for a SimpleMetric, used to update many metrics in one call with Publishable::updateMetrics.
+ * Only fixed width types are supported.
+ *
+ * @tparam T The type of the metric
+ */
+template <typename T>
+    requires std::is_trivially_copyable<T>::value
+struct MetricUpdate
+{
+    SimpleMetric<T> *metric;
+    T value;
 };
 
 #endif /* SRC_METRICS_SIMPLE_SIMPLEMETRIC */
@@ -68,17 +68,23 @@ public:
      */
     void setValue(std::string value)
     {
+        MetricLock lock = lockOwner();
+
         if (size == value.length() + 1)
         {
-            (dirty = (dirty || memcmp(value.c_str(), data, size) != 0)) && memcpy(data, value.c_str(), size);
+            if (dirty || memcmp(value.c_str(), data, size) != 0)
+            {
+                memcpy(data, value.c_str(), size);
+                markDirty();
+            }
             changedTime = TimeManager::getTime();
             return;
         }
-        dirty = true;
         free(data);
         size = value.length() + 1;
         data = strdup(value.c_str());
         changedTime = TimeManager::getTime();
+        markDirty();
     }
 
     std::string getValue()
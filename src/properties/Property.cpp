@@ -139,6 +139,106 @@ int Property::addToPropertySet(org_eclipse_tahu_protobuf_Payload_PropertySet *pr
     return 0;
 }
 
+bool Property::isIncluded(bool isBirth)
+{
+    return dirty || isBirth;
+}
+
+/**
+ * @brief Writes the value field of a protobuf property value, for the types properties are stored as
+ *
+ * @return true if the value was written
+ */
+static bool encodePropertyValue(pb_ostream_t *stream, uint8_t dataType, void *data)
+{
+    switch (dataType)
+    {
+    case PROPERTY_DATA_TYPE_INT8:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_int_value_tag) &&
+               pb_encode_varint(stream, (uint32_t)(*(int8_t *)data));
+    case PROPERTY_DATA_TYPE_INT16:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_int_value_tag) &&
+               pb_encode_varint(stream, (uint32_t)(*(int16_t *)data));
+    case PROPERTY_DATA_TYPE_INT32:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_int_value_tag) &&
+               pb_encode_varint(stream, (uint32_t)(*(int32_t *)data));
+    case PROPERTY_DATA_TYPE_UINT8:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_int_value_tag) &&
+               pb_encode_varint(stream, *(uint8_t *)data);
+    case PROPERTY_DATA_TYPE_UINT16:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_int_value_tag) &&
+               pb_encode_varint(stream, *(uint16_t *)data);
+    case PROPERTY_DATA_TYPE_UINT32:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_int_value_tag) &&
+               pb_encode_varint(stream, *(uint32_t *)data);
+    case PROPERTY_DATA_TYPE_INT64:
+    case PROPERTY_DATA_TYPE_UINT64:
+    case PROPERTY_DATA_TYPE_DATETIME:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_long_value_tag) &&
+               pb_encode_varint(stream, *(uint64_t *)data);
+    case PROPERTY_DATA_TYPE_FLOAT:
+        return pb_encode_tag(stream, PB_WT_32BIT, org_eclipse_tahu_protobuf_Payload_PropertyValue_float_value_tag) &&
+               pb_encode_fixed32(stream, data);
+    case PROPERTY_DATA_TYPE_DOUBLE:
+        return pb_encode_tag(stream, PB_WT_64BIT, org_eclipse_tahu_protobuf_Payload_PropertyValue_double_value_tag) &&
+               pb_encode_fixed64(stream, data);
+    case PROPERTY_DATA_TYPE_BOOLEAN:
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_boolean_value_tag) &&
+               pb_encode_varint(stream, *(bool *)data);
+    case PROPERTY_DATA_TYPE_STRING:
+    case PROPERTY_DATA_TYPE_TEXT:
+        return pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_PropertyValue_string_value_tag) &&
+               pb_encode_string(stream, (const pb_byte_t *)data, strlen((char *)data));
+    default:
+        return false;
+    }
+}
+
+bool Property::encodeValue(pb_ostream_t *stream, __attribute__((unused)) bool isBirth)
+{
+    // Fields are written in field number order, as nanopb would encode the struct form
+    if (!pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_type_tag) || !pb_encode_varint(stream, dataType))
+    {
+        return false;
+    }
+
+    if (data == NULL)
+    {
+        return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_is_null_tag) && pb_encode_varint(stream, true);
+    }
+
+    return encodePropertyValue(stream, dataType, data);
+}
+
+bool Property::encodePropertySet(pb_ostream_t *stream, const std::vector<std::shared_ptr<Property>> &properties, bool isBirth)
+{
+    // The repeated keys are written before the repeated values, matching the order of the struct form
+    for (auto &property : properties)
+    {
+        if (!property->isIncluded(isBirth))
+        {
+            continue;
+        }
+        if (!pb_encode_tag(stream, PB_WT_STRING, org_eclipse_tahu_protobuf_Payload_PropertySet_keys_tag) ||
+            !pb_encode_string(stream, (const pb_byte_t *)property->name, strlen(property->name)))
+        {
+            return false;
+        }
+    }
+
+    for (auto &property : properties)
+    {
+        if (property->isIncluded(isBirth) &&
+            !encodeProtobufSubmessage(stream, org_eclipse_tahu_protobuf_Payload_PropertySet_values_tag, [&property, isBirth](pb_ostream_t *substream)
+                                      { return property->encodeValue(substream, isBirth); }))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void Property::setValue(void *data)
 {
     (dirty = (dirty || memcmp(data, this->data, size) != 0)) && memcpy(this->data, data, size);
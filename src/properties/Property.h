@@ -33,6 +33,9 @@
 #define SRC_PROPERTIES_PROPERTY
 
 #include <tahu.h>
+#include <vector>
+#include <memory>
+#include "utils/Protobuf.h"
 
 class Property
 {
@@ -68,6 +71,31 @@ public:
      * @return int
      */
     virtual int addToPropertySet(org_eclipse_tahu_protobuf_Payload_PropertySet *propertySet, bool isBirth);
+    /**
+     * @brief Whether the property is included when its property set is encoded
+     *
+     * @param isBirth If the property set is a part of a birth message
+     * @return true
+     * @return false
+     */
+    virtual bool isIncluded(bool isBirth);
+    /**
+     * @brief Writes the fields of a protobuf PropertyValue for the property straight from its storage
+     *
+     * @param stream The stream the PropertyValue is written to
+     * @param isBirth If the property is a part of a birth message
+     * @return true if the value was encoded
+     */
+    virtual bool encodeValue(pb_ostream_t *stream, bool isBirth);
+    /**
+     * @brief Writes the fields of a protobuf PropertySet holding the included properties, without building the struct form of the set
+     *
+     * @param stream The stream the PropertySet is written to
+     * @param properties The properties of the set
+     * @param isBirth If the property set is a part of a birth message
+     * @return true if the property set was encoded
+     */
+    static bool encodePropertySet(pb_ostream_t *stream, const std::vector<std::shared_ptr<Property>> &properties, bool isBirth);
     /**
      * @brief Sets a new value of the property
      *
@@ -80,12 +108,12 @@ public:
      * @return true
      * @return false
      */
-    bool isDirty();
+    virtual bool isDirty();
     /**
      * @brief Used to mark the property that is had been published
      *
      */
-    void published();
+    virtual void published();
     /**
      * @brief Returns the pointer to the property data
      *
@@ -30,6 +30,26 @@ int PropertySet::addToPropertySet(org_eclipse_tahu_protobuf_Payload_PropertySet
     return 0;
 }
 
+bool PropertySet::isIncluded(bool isBirth)
+{
+    for (auto &property : properties)
+    {
+        if (property->isIncluded(isBirth))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PropertySet::encodeValue(pb_ostream_t *stream, bool isBirth)
+{
+    return pb_encode_tag(stream, PB_WT_VARINT, org_eclipse_tahu_protobuf_Payload_PropertyValue_type_tag) &&
+           pb_encode_varint(stream, PROPERTY_DATA_TYPE_PROPERTYSET) &&
+           encodeProtobufSubmessage(stream, org_eclipse_tahu_protobuf_Payload_PropertyValue_propertyset_value_tag, [this, isBirth](pb_ostream_t *substream)
+                                    { return encodePropertySet(substream, properties, isBirth); });
+}
+
 void PropertySet::addProperty(const std::shared_ptr<Property> &property)
 {
     properties.push_back(std::move(property));
@@ -42,6 +62,26 @@ void PropertySet::addProperties(const std::vector<std::shared_ptr<Property>> &pr
         addProperty(property);
     }
 }
+
+bool PropertySet::isDirty()
+{
+    for (auto &property : properties)
+    {
+        if (property->isDirty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PropertySet::published()
+{
+    for (auto &property : properties)
+    {
+        property->published();
+    }
+}
 std::shared_ptr<PropertySet> PropertySet::create(const char *name)
 {
 
@@ -34,6 +34,23 @@ public:
      */
     int addToPropertySet(org_eclipse_tahu_protobuf_Payload_PropertySet *propertySet, bool isBirth) override;
 
+    /**
+     * @brief Whether any property in the set is included when the set is encoded
+     *
+     * @param isBirth
+     * @return true
+     * @return false
+     */
+    bool isIncluded(bool isBirth) override;
+    /**
+     * @brief Writes the property set as a protobuf PropertyValue holding its included properties
+     *
+     * @param stream
+     * @param isBirth
+     * @return true if the value was encoded
+     */
+    bool encodeValue(pb_ostream_t *stream, bool isBirth) override;
+
     /**
      * @brief Add a property to the property set
      *
@@ -41,6 +58,18 @@ public:
      */
     void addProperty(const std::shared_ptr<Property> &property);
     void addProperties(const std::vector<std::shared_ptr<Property>> &properties);
+
+    /**
+     * @brief Whether any property in the set is dirty
+     *
+     * @return true
+     * @return false
+     */
+    bool isDirty() override;
+    /**
+     * @brief Marks every property in the set as published
+     */
+    void published() override;
 };
 
 #endif /* SRC_PROPERTIES_COMPLEX_PROPERTYSET */
@@ -46,7 +46,7 @@ private:
      * @param name The name of the Sparkplug Property
      * @param data The first value of the property
      */
-    StringProperty(const char *name, std::string data) : SimpleProperty(name, (void *)data.c_str(), data.size(), PROPERTY_DATA_TYPE_STRING){};
+    StringProperty(const char *name, std::string data) : SimpleProperty(name, (void *)data.c_str(), data.size() + 1, PROPERTY_DATA_TYPE_STRING){};
 
 public:
     /**
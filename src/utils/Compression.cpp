@@ -0,0 +1,178 @@
+/*
+ * File: Compression.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "Compression.h"
+#include "TimeManager.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+#define DEFLATE_NAME "DEFLATE"
+#define GZIP_NAME "GZIP"
+
+// zlib window bits, adding 16 uses a gzip wrapper, adding 32 detects either wrapper when inflating
+#define DEFLATE_WINDOW_BITS MAX_WBITS
+#define GZIP_WINDOW_BITS (MAX_WBITS + 16)
+#define INFLATE_WINDOW_BITS (MAX_WBITS + 32)
+
+#define INFLATE_CHUNK_SIZE 4096
+
+int compressPayload(CompressionAlgorithm algorithm, const uint8_t *encoded, size_t length, org_eclipse_tahu_protobuf_Payload *envelope)
+{
+    const char *algorithmName;
+    int windowBits;
+
+    switch (algorithm)
+    {
+    case COMPRESSION_DEFLATE:
+        algorithmName = DEFLATE_NAME;
+        windowBits = DEFLATE_WINDOW_BITS;
+        break;
+    case COMPRESSION_GZIP:
+        algorithmName = GZIP_NAME;
+        windowBits = GZIP_WINDOW_BITS;
+        break;
+    default:
+        return -1;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return -1;
+    }
+
+    size_t bound = deflateBound(&stream, length);
+
+    // The body of a payload can not hold more than pb_size_t bytes
+    if (bound > std::numeric_limits<pb_size_t>::max())
+    {
+        deflateEnd(&stream);
+        return -1;
+    }
+
+    pb_bytes_array_t *body = (pb_bytes_array_t *)malloc(PB_BYTES_ARRAY_T_ALLOCSIZE(bound));
+
+    if (body == NULL)
+    {
+        deflateEnd(&stream);
+        return -1;
+    }
+
+    stream.next_in = (Bytef *)encoded;
+    stream.avail_in = length;
+    stream.next_out = body->bytes;
+    stream.avail_out = bound;
+
+    int result = deflate(&stream, Z_FINISH);
+    body->size = (pb_size_t)stream.total_out;
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END)
+    {
+        free(body);
+        return -1;
+    }
+
+    memset(envelope, 0, sizeof(org_eclipse_tahu_protobuf_Payload));
+    envelope->has_timestamp = true;
+    envelope->timestamp = TimeManager::getTime();
+    envelope->uuid = strdup(SPARKPLUG_COMPRESSED_UUID);
+    envelope->body = body;
+
+    org_eclipse_tahu_protobuf_Payload_Metric metric;
+    init_metric(&metric, SPARKPLUG_COMPRESSION_ALGORITHM_METRIC, false, 0, METRIC_DATA_TYPE_STRING, false, false, algorithmName, strlen(algorithmName) + 1);
+    add_metric_to_payload(envelope, &metric);
+
+    return 0;
+}
+
+/**
+ * @brief Whether an algorithm name is one of the supported algorithms, ignoring case
+ */
+static bool isSupportedAlgorithm(std::string_view algorithm)
+{
+    return (algorithm.size() == strlen(DEFLATE_NAME) && strncasecmp(algorithm.data(), DEFLATE_NAME, algorithm.size()) == 0) ||
+           (algorithm.size() == strlen(GZIP_NAME) && strncasecmp(algorithm.data(), GZIP_NAME, algorithm.size()) == 0);
+}
+
+int decompressBody(std::string_view algorithm, const uint8_t *body, size_t length, std::vector<uint8_t> &decompressed, size_t maxLength)
+{
+    // Both DEFLATE and GZIP bodies are handled by zlib's header detection, so the algorithm is only validated
+    if (!algorithm.empty() && !isSupportedAlgorithm(algorithm))
+    {
+        return -1;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (inflateInit2(&stream, INFLATE_WINDOW_BITS) != Z_OK)
+    {
+        return -1;
+    }
+
+    decompressed.clear();
+    int result = Z_OK;
+
+    stream.next_in = (Bytef *)body;
+    stream.avail_in = length;
+
+    while (result == Z_OK)
+    {
+        size_t offset = decompressed.size();
+        size_t chunk = std::min((size_t)INFLATE_CHUNK_SIZE, maxLength - offset);
+
+        // Output is only ever grown up to the limit, so a body that keeps inflating past it is rejected
+        if (chunk == 0)
+        {
+            result = Z_BUF_ERROR;
+            break;
+        }
+
+        decompressed.resize(offset + chunk);
+
+        stream.next_out = decompressed.data() + offset;
+        stream.avail_out = chunk;
+
+        result = inflate(&stream, Z_NO_FLUSH);
+        decompressed.resize(offset + chunk - stream.avail_out);
+    }
+
+    inflateEnd(&stream);
+
+    return result == Z_STREAM_END ? 0 : -1;
+}
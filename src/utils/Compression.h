@@ -0,0 +1,93 @@
+/*
+ * File: Compression.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_COMPRESSION
+#define SRC_UTILS_COMPRESSION
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+#include <tahu.h>
+
+/**
+ * @brief The UUID used by Sparkplug to mark a payload whose body holds a compressed payload
+ */
+#define SPARKPLUG_COMPRESSED_UUID "SPBV1.0_COMPRESSED"
+/**
+ * @brief The name of the metric that holds the compression algorithm of a compressed payload
+ */
+#define SPARKPLUG_COMPRESSION_ALGORITHM_METRIC "algorithm"
+
+/**
+ * @brief The largest encoded payload a compressed payload envelope may inflate to.
+ * Bounds the memory a small, highly compressed body received from the broker can claim.
+ */
+#ifndef COMPRESSION_MAX_DECOMPRESSED_SIZE
+#define COMPRESSION_MAX_DECOMPRESSED_SIZE (1024 * 1024)
+#endif
+
+/**
+ * @brief Algorithms that can be used to compress Sparkplug payloads
+ */
+enum CompressionAlgorithm
+{
+    COMPRESSION_NONE = 0,
+    COMPRESSION_DEFLATE,
+    COMPRESSION_GZIP
+};
+
+/**
+ * @brief Builds a Sparkplug compressed payload envelope from an encoded payload.
+ * The envelope holds the compressed payload as its body, along with the algorithm used.
+ *
+ * @param algorithm The algorithm used to compress the payload
+ * @param encoded The encoded payload
+ * @param length The length of the encoded payload
+ * @param envelope The payload that will hold the compressed payload. Must be freed with free_payload.
+ * @return int 0 on success, -1 if the payload could not be compressed
+ */
+int compressPayload(CompressionAlgorithm algorithm, const uint8_t *encoded, size_t length, org_eclipse_tahu_protobuf_Payload *envelope);
+
+/**
+ * @brief Inflates the body of a Sparkplug compressed payload envelope into the encoded payload it holds
+ *
+ * @param algorithm The value of the envelope's algorithm metric, or an empty view if it has none
+ * @param body The body of the envelope
+ * @param length The length of the body
+ * @param decompressed The buffer the encoded payload is inflated into, replacing its contents
+ * @param maxLength The largest encoded payload the body may inflate to
+ * @return int 0 on success, -1 if the algorithm is not supported, the body could not be inflated or inflates beyond maxLength
+ */
+int decompressBody(std::string_view algorithm, const uint8_t *body, size_t length, std::vector<uint8_t> &decompressed,
+                   size_t maxLength = COMPRESSION_MAX_DECOMPRESSED_SIZE);
+
+#endif /* SRC_UTILS_COMPRESSION */
@@ -0,0 +1,172 @@
+/*
+ * File: MpscQueue.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_MPSCQUEUE
+#define SRC_UTILS_MPSCQUEUE
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A bounded lock-free Multi Producer Single Consumer queue.
+ * Any number of threads may push into the queue, while only a single thread may pop from it.
+ * Each slot carries a sequence number which is used to hand ownership of the slot
+ * between the producers and the consumer without any locking.
+ *
+ * @tparam T The type of the items stored in the queue. Must be copy assignable.
+ * @tparam Capacity The maximum number of items held by the queue. Must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class MpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    typedef struct
+    {
+        std::atomic<size_t> sequence;
+        T item;
+    } Slot;
+
+    Slot slots[Capacity];
+    alignas(CACHE_LINE) std::atomic<size_t> tail;
+    alignas(CACHE_LINE) size_t head;
+
+public:
+    MpscQueue() : tail(0), head(0)
+    {
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    };
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /**
+     * @brief Attempts to push an item into the queue. Safe to call from multiple threads.
+     *
+     * @param item The item to be copied into the queue
+     * @return true The item was queued
+     * @return false The queue is full
+     */
+    bool push(const T &item)
+    {
+        Slot *slot;
+        size_t position = tail.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            slot = &slots[position & MASK];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+            if (difference == 0)
+            {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->item = item;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    };
+
+    /**
+     * @brief Attempts to pop an item from the queue. Must only be called from the consuming thread.
+     *
+     * @param item Destination for the popped item
+     * @return true An item was popped
+     * @return false The queue is empty, or the next item is still being written
+     */
+    bool pop(T &item)
+    {
+        Slot *slot = &slots[head & MASK];
+
+        if (slot->sequence.load(std::memory_order_acquire) != head + 1)
+        {
+            return false;
+        }
+
+        item = slot->item;
+        slot->sequence.store(head + Capacity, std::memory_order_release);
+        head++;
+        return true;
+    };
+
+    /**
+     * @brief Pops up to count items from the queue in a single pass.
+     * Must only be called from the consuming thread.
+     *
+     * @param items Destination array for the popped items
+     * @param count The maximum number of items to pop
+     * @return size_t The number of items popped
+     */
+    size_t drain(T *items, size_t count)
+    {
+        size_t popped = 0;
+
+        while (popped < count && pop(items[popped]))
+        {
+            popped++;
+        }
+
+        return popped;
+    };
+
+    /**
+     * @brief The maximum number of items the queue can hold
+     *
+     * @return size_t
+     */
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    };
+};
+
+#endif /* SRC_UTILS_MPSCQUEUE */
@@ -0,0 +1,297 @@
+/*
+ * File: Protobuf.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_PROTOBUF
+#define SRC_UTILS_PROTOBUF
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <pb_encode.h>
+
+/**
+ * @brief Builds the protobuf key of a field from its field number and wire type
+ */
+#define PROTOBUF_KEY(field, wireType) (((field) << 3) | (wireType))
+
+#define PROTOBUF_WIRE_VARINT 0
+#define PROTOBUF_WIRE_FIXED64 1
+#define PROTOBUF_WIRE_LENGTH 2
+#define PROTOBUF_WIRE_FIXED32 5
+
+// Keys of the Sparkplug payload fields that are written directly rather than through nanopb
+#define PAYLOAD_TIMESTAMP_KEY PROTOBUF_KEY(1, PROTOBUF_WIRE_VARINT)
+#define PAYLOAD_METRIC_KEY PROTOBUF_KEY(2, PROTOBUF_WIRE_LENGTH)
+#define PAYLOAD_SEQUENCE_KEY PROTOBUF_KEY(3, PROTOBUF_WIRE_VARINT)
+#define METRIC_TIMESTAMP_KEY PROTOBUF_KEY(3, PROTOBUF_WIRE_VARINT)
+
+/**
+ * @brief Get the number of bytes a value takes when encoded as a protobuf varint
+ *
+ * @param value
+ * @return size_t
+ */
+inline size_t protobufVarintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/**
+ * @brief Appends a value to a buffer as a protobuf varint
+ *
+ * @param buffer
+ * @param value
+ */
+inline void appendProtobufVarint(std::vector<uint8_t> &buffer, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buffer.push_back(value > 0 ? byte | 0x80 : byte);
+    } while (value > 0);
+}
+
+/**
+ * @brief Reads the fields of an encoded protobuf message in place, without decoding the message into its struct form.
+ * Length delimited fields are returned as pointers into the message, so nothing is allocated or copied.
+ */
+class ProtobufReader
+{
+private:
+    const uint8_t *position;
+    const uint8_t *end;
+
+public:
+    /**
+     * @brief Construct a new reader over an encoded message
+     *
+     * @param data The encoded message
+     * @param length The length of the message
+     */
+    ProtobufReader(const uint8_t *data, size_t length) : position(data), end(data + length){};
+
+    /**
+     * @brief Whether every field of the message has been read
+     *
+     * @return true
+     * @return false
+     */
+    bool isAtEnd() const
+    {
+        return position >= end;
+    }
+
+    /**
+     * @brief Reads a varint
+     *
+     * @param value The value read
+     * @return true if a complete varint was read
+     */
+    bool readVarint(uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && position < end; shift += 7)
+        {
+            uint8_t byte = *position++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Reads the key of the next field
+     *
+     * @param field The field number
+     * @param wireType The wire type of the field
+     * @return true if a key was read
+     */
+    bool readKey(uint32_t &field, uint8_t &wireType)
+    {
+        uint64_t key;
+        if (!readVarint(key) || (key >> 3) == 0 || (key >> 3) > UINT32_MAX)
+        {
+            return false;
+        }
+        field = key >> 3;
+        wireType = key & 0x07;
+        return true;
+    }
+
+    /**
+     * @brief Reads the value of a length delimited field
+     *
+     * @param data Set to the start of the value within the message
+     * @param length The length of the value
+     * @return true if the value lies within the message
+     */
+    bool readLengthDelimited(const uint8_t *&data, size_t &length)
+    {
+        uint64_t size;
+        if (!readVarint(size) || size > (uint64_t)(end - position))
+        {
+            return false;
+        }
+        data = position;
+        length = size;
+        position += size;
+        return true;
+    }
+
+    /**
+     * @brief Reads the little endian value of a fixed width field
+     *
+     * @param value The value read
+     * @param size The width of the field, 4 or 8 bytes
+     * @return true if the value lies within the message
+     */
+    bool readFixed(uint64_t &value, size_t size)
+    {
+        if ((size_t)(end - position) < size)
+        {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            value |= (uint64_t)position[i] << (i * 8);
+        }
+        position += size;
+        return true;
+    }
+
+    /**
+     * @brief Skips the value of a field
+     *
+     * @param wireType The wire type of the field
+     * @return true if the value was skipped
+     */
+    bool skip(uint8_t wireType)
+    {
+        uint64_t value;
+        const uint8_t *data;
+        size_t length;
+
+        switch (wireType)
+        {
+        case PROTOBUF_WIRE_VARINT:
+            return readVarint(value);
+        case PROTOBUF_WIRE_LENGTH:
+            return readLengthDelimited(data, length);
+        case PROTOBUF_WIRE_FIXED64:
+        case PROTOBUF_WIRE_FIXED32:
+            length = wireType == PROTOBUF_WIRE_FIXED64 ? 8 : 4;
+            if ((size_t)(end - position) < length)
+            {
+                return false;
+            }
+            position += length;
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+/**
+ * @brief Stream callback that appends the written bytes to the std::vector<uint8_t> held in the stream's state
+ */
+inline bool protobufVectorWrite(pb_ostream_t *stream, const pb_byte_t *buf, size_t count)
+{
+    std::vector<uint8_t> *buffer = (std::vector<uint8_t> *)stream->state;
+    buffer->insert(buffer->end(), buf, buf + count);
+    return true;
+}
+
+/**
+ * @brief Creates a nanopb output stream that appends to a buffer, growing it as needed
+ *
+ * @param buffer
+ * @return pb_ostream_t
+ */
+inline pb_ostream_t protobufStreamFromVector(std::vector<uint8_t> &buffer)
+{
+    pb_ostream_t stream = PB_OSTREAM_SIZING;
+    stream.callback = &protobufVectorWrite;
+    stream.state = &buffer;
+    stream.max_size = SIZE_MAX;
+    return stream;
+}
+
+/**
+ * @brief The size of the stack buffer small submessages are encoded into before being copied to their stream
+ */
+#ifndef PROTOBUF_SUBMESSAGE_SCRATCH_SIZE
+#define PROTOBUF_SUBMESSAGE_SCRATCH_SIZE 256
+#endif
+
+/**
+ * @brief Encodes a length delimited submessage field, with its fields written by an encode function.
+ * Submessages are encoded once into a stack buffer and copied to the stream. Those too large for the buffer
+ * are encoded twice instead, once on a sizing stream to find their length and once to write them.
+ *
+ * @param stream The stream the submessage is written to
+ * @param field The field number of the submessage
+ * @param encode A function taking a pb_ostream_t * that writes the fields of the submessage, returning false on failure
+ * @return true if the submessage was encoded
+ */
+template <typename F>
+bool encodeProtobufSubmessage(pb_ostream_t *stream, uint32_t field, F encode)
+{
+    pb_byte_t scratch[PROTOBUF_SUBMESSAGE_SCRATCH_SIZE];
+    pb_ostream_t scratchStream = pb_ostream_from_buffer(scratch, sizeof(scratch));
+
+    if (encode(&scratchStream))
+    {
+        return pb_encode_tag(stream, PB_WT_STRING, field) &&
+               pb_encode_varint(stream, scratchStream.bytes_written) &&
+               pb_write(stream, scratch, scratchStream.bytes_written);
+    }
+
+    pb_ostream_t sizing = PB_OSTREAM_SIZING;
+
+    return encode(&sizing) &&
+           pb_encode_tag(stream, PB_WT_STRING, field) &&
+           pb_encode_varint(stream, sizing.bytes_written) &&
+           encode(stream);
+}
+
+#endif /* SRC_UTILS_PROTOBUF */
@@ -0,0 +1,76 @@
+/*
+ * File: PublishRequestPool.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "PublishRequestPool.h"
+#include "Statistics.h"
+
+PublishRequestPool::PublishRequestPool()
+{
+    for (auto &request : requests)
+    {
+        request.pool = this;
+        available.push(&request);
+    }
+}
+
+PublishRequest *PublishRequestPool::acquire(bool isBirth, Publishable *publisher, const std::string *topic)
+{
+    PublishRequest *publishRequest;
+
+    if (!available.pop(publishRequest))
+    {
+        publishRequest = new PublishRequest(isBirth, publisher, topic, -1, 0);
+        publishRequest->requestTime = statisticsTime();
+        return publishRequest;
+    }
+
+    publishRequest->isBirth = isBirth;
+    publishRequest->publisher = publisher;
+    publishRequest->topic = topic;
+    publishRequest->token = -1;
+    publishRequest->retryCount = 0;
+    publishRequest->encodedLength = 0;
+    publishRequest->requestTime = statisticsTime();
+    publishRequest->sendTime = 0;
+
+    return publishRequest;
+}
+
+void PublishRequestPool::release(PublishRequest *publishRequest)
+{
+    if (publishRequest->encoded.capacity() > PUBLISH_REQUEST_POOL_MAX_RETAINED)
+    {
+        std::vector<uint8_t>().swap(publishRequest->encoded);
+    }
+
+    // The queue holds every request in the pool, so there is always room to return one
+    available.push(publishRequest);
+}
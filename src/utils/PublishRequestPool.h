@@ -0,0 +1,87 @@
+/*
+ * File: PublishRequestPool.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_PUBLISHREQUESTPOOL
+#define SRC_UTILS_PUBLISHREQUESTPOOL
+
+#include "CommonTypes.h"
+#include "MpscQueue.h"
+
+/**
+ * @brief The number of PublishRequests held by a PublishRequestPool
+ */
+#ifndef PUBLISH_REQUEST_POOL_SIZE
+#define PUBLISH_REQUEST_POOL_SIZE 64
+#endif
+
+/**
+ * @brief The largest encoded payload buffer a pooled PublishRequest keeps when it is released.
+ * Larger buffers are freed, so a single large birth does not pin memory in every request of the pool.
+ */
+#ifndef PUBLISH_REQUEST_POOL_MAX_RETAINED
+#define PUBLISH_REQUEST_POOL_MAX_RETAINED 16384
+#endif
+
+/**
+ * @brief A fixed pool of PublishRequests that are recycled between publishes.
+ * Requests must only be acquired from a single thread, but may be released from any thread,
+ * such as the callback threads of a client. Once the pool is exhausted requests are allocated on the heap.
+ */
+class PublishRequestPool
+{
+private:
+    PublishRequest requests[PUBLISH_REQUEST_POOL_SIZE];
+    MpscQueue<PublishRequest *, PUBLISH_REQUEST_POOL_SIZE> available;
+
+public:
+    PublishRequestPool();
+
+    PublishRequestPool(const PublishRequestPool &) = delete;
+    PublishRequestPool &operator=(const PublishRequestPool &) = delete;
+
+    /**
+     * @brief Acquires a PublishRequest from the pool
+     *
+     * @param isBirth If the request is for a birth message
+     * @param publisher The Publishable being published
+     * @param topic The topic the request will be published on
+     * @return PublishRequest*
+     */
+    PublishRequest *acquire(bool isBirth, Publishable *publisher, const std::string *topic);
+    /**
+     * @brief Returns a PublishRequest to the pool, freeing its encoded payload if it grew beyond PUBLISH_REQUEST_POOL_MAX_RETAINED
+     *
+     * @param publishRequest
+     */
+    void release(PublishRequest *publishRequest);
+};
+
+#endif /* SRC_UTILS_PUBLISHREQUESTPOOL */
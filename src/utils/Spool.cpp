@@ -0,0 +1,385 @@
+/*
+ * File: Spool.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "Spool.h"
+#include <algorithm>
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+#define SPOOL_MAGIC 0x53504253
+#define SPOOL_VERSION 1
+#define SPOOL_EXTENSION ".spool"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t writeOffset;
+    uint64_t readOffset;
+} SpoolSegmentHeader;
+
+typedef struct
+{
+    uint32_t topicLength;
+    uint32_t payloadLength;
+} SpoolRecordHeader;
+
+#define SEGMENT_HEADER(segment) ((SpoolSegmentHeader *)(segment).map)
+
+Spool::~Spool()
+{
+    close();
+}
+
+std::string Spool::segmentPath(uint64_t index)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llu" SPOOL_EXTENSION, (unsigned long long)index);
+    return directory + "/" + name;
+}
+
+int Spool::loadSegment(uint64_t index)
+{
+    std::string path = segmentPath(index);
+    int file = ::open(path.c_str(), O_RDWR);
+
+    if (file < 0)
+    {
+        return -1;
+    }
+
+    struct stat status;
+    uint8_t *map = (uint8_t *)MAP_FAILED;
+
+    if (fstat(file, &status) == 0 && (size_t)status.st_size > sizeof(SpoolSegmentHeader))
+    {
+        map = (uint8_t *)mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+
+    if (map == MAP_FAILED)
+    {
+        ::close(file);
+        unlink(path.c_str());
+        return -1;
+    }
+
+    Segment segment = {index, file, map, (size_t)status.st_size};
+    SpoolSegmentHeader *header = SEGMENT_HEADER(segment);
+
+    if (header->magic != SPOOL_MAGIC || header->version != SPOOL_VERSION ||
+        header->writeOffset > segment.length || header->readOffset > header->writeOffset ||
+        header->readOffset < sizeof(SpoolSegmentHeader))
+    {
+        munmap(map, segment.length);
+        ::close(file);
+        unlink(path.c_str());
+        return -1;
+    }
+
+    segments.push_back(segment);
+    totalBytes += segment.length;
+    return 0;
+}
+
+int Spool::createSegment(size_t recordLength)
+{
+    size_t length = std::max(std::min((size_t)SPOOL_SEGMENT_SIZE, maxBytes), sizeof(SpoolSegmentHeader) + recordLength);
+
+    if (length > maxBytes)
+    {
+        return -1;
+    }
+
+    // Drop the oldest records to stay within the size cap
+    while (!segments.empty() && totalBytes + length > maxBytes)
+    {
+        removeSegment();
+    }
+
+    uint64_t index = nextIndex++;
+    std::string path = segmentPath(index);
+    int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (file < 0)
+    {
+        return -1;
+    }
+
+    if (ftruncate(file, length) != 0)
+    {
+        ::close(file);
+        unlink(path.c_str());
+        return -1;
+    }
+
+    uint8_t *map = (uint8_t *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+    if (map == MAP_FAILED)
+    {
+        ::close(file);
+        unlink(path.c_str());
+        return -1;
+    }
+
+    Segment segment = {index, file, map, length};
+    SpoolSegmentHeader *header = SEGMENT_HEADER(segment);
+
+    header->magic = SPOOL_MAGIC;
+    header->version = SPOOL_VERSION;
+    header->writeOffset = sizeof(SpoolSegmentHeader);
+    header->readOffset = sizeof(SpoolSegmentHeader);
+
+    segments.push_back(segment);
+    totalBytes += length;
+    return 0;
+}
+
+void Spool::removeSegment()
+{
+    Segment &segment = segments.front();
+
+    munmap(segment.map, segment.length);
+    ::close(segment.file);
+    unlink(segmentPath(segment.index).c_str());
+
+    totalBytes -= segment.length;
+    segments.pop_front();
+}
+
+int Spool::open(const char *directory, size_t maxBytes)
+{
+    close();
+
+    if (directory == NULL || maxBytes <= sizeof(SpoolSegmentHeader))
+    {
+        return -1;
+    }
+
+    this->directory = directory;
+    this->maxBytes = maxBytes;
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST)
+    {
+        return -1;
+    }
+
+    DIR *handle = opendir(directory);
+
+    if (handle == NULL)
+    {
+        return -1;
+    }
+
+    std::vector<uint64_t> indexes;
+    struct dirent *entry;
+
+    while ((entry = readdir(handle)) != NULL)
+    {
+        unsigned long long index;
+        char extension[8] = {0};
+
+        if (sscanf(entry->d_name, "%llu%7s", &index, extension) == 2 && strcmp(extension, SPOOL_EXTENSION) == 0)
+        {
+            indexes.push_back(index);
+        }
+    }
+
+    closedir(handle);
+
+    std::sort(indexes.begin(), indexes.end());
+
+    for (uint64_t index : indexes)
+    {
+        loadSegment(index);
+        nextIndex = index + 1;
+    }
+
+    return 0;
+}
+
+void Spool::close()
+{
+    for (auto &segment : segments)
+    {
+        munmap(segment.map, segment.length);
+        ::close(segment.file);
+    }
+
+    segments.clear();
+    peeked = false;
+    directory.clear();
+    totalBytes = 0;
+    maxBytes = 0;
+    nextIndex = 0;
+}
+
+bool Spool::isOpen()
+{
+    return maxBytes > 0;
+}
+
+int Spool::append(std::string_view topic, const uint8_t *payload, size_t length)
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
+
+    SpoolRecordHeader record = {(uint32_t)topic.size(), (uint32_t)length};
+    size_t recordLength = sizeof(record) + topic.size() + length;
+
+    if (segments.empty() || SEGMENT_HEADER(segments.back())->writeOffset + recordLength > segments.back().length)
+    {
+        if (createSegment(recordLength) != 0)
+        {
+            return -1;
+        }
+    }
+
+    Segment &segment = segments.back();
+    SpoolSegmentHeader *header = SEGMENT_HEADER(segment);
+    uint8_t *destination = segment.map + header->writeOffset;
+
+    memcpy(destination, &record, sizeof(record));
+    memcpy(destination + sizeof(record), topic.data(), topic.size());
+    memcpy(destination + sizeof(record) + topic.size(), payload, length);
+
+    // The offset is only moved once the record has been written, so a partial record is never replayed
+    header->writeOffset += recordLength;
+
+    return 0;
+}
+
+bool Spool::peek(std::string_view &topic, const uint8_t *&payload, size_t &length)
+{
+    while (!segments.empty())
+    {
+        Segment &segment = segments.front();
+        SpoolSegmentHeader *header = SEGMENT_HEADER(segment);
+
+        if (header->readOffset < header->writeOffset)
+        {
+            SpoolRecordHeader record;
+            uint8_t *source = segment.map + header->readOffset;
+
+            memcpy(&record, source, sizeof(record));
+
+            // Records that run past the written data are corrupt, skip the rest of the segment
+            if (header->readOffset + sizeof(record) + record.topicLength + record.payloadLength > header->writeOffset)
+            {
+                header->readOffset = header->writeOffset;
+                continue;
+            }
+
+            peeked = true;
+            peekedIndex = segment.index;
+            peekedOffset = header->readOffset;
+
+            topic = std::string_view((const char *)source + sizeof(record), record.topicLength);
+            payload = source + sizeof(record) + record.topicLength;
+            length = record.payloadLength;
+            return true;
+        }
+
+        if (segments.size() == 1)
+        {
+            return false;
+        }
+
+        removeSegment();
+    }
+
+    return false;
+}
+
+void Spool::pop()
+{
+    if (!peeked || segments.empty())
+    {
+        return;
+    }
+
+    peeked = false;
+    Segment &segment = segments.front();
+    SpoolSegmentHeader *header = SEGMENT_HEADER(segment);
+
+    // The peeked record is gone if its segment was dropped while it was being replayed
+    if (segment.index != peekedIndex || header->readOffset != peekedOffset || header->readOffset >= header->writeOffset)
+    {
+        return;
+    }
+
+    SpoolRecordHeader record;
+    memcpy(&record, segment.map + header->readOffset, sizeof(record));
+    header->readOffset += sizeof(record) + record.topicLength + record.payloadLength;
+
+    if (header->readOffset < header->writeOffset)
+    {
+        return;
+    }
+
+    if (segments.size() > 1)
+    {
+        removeSegment();
+    }
+    else
+    {
+        // The last segment is reused rather than recreated
+        header->readOffset = sizeof(SpoolSegmentHeader);
+        header->writeOffset = sizeof(SpoolSegmentHeader);
+    }
+}
+
+bool Spool::isEmpty()
+{
+    for (auto &segment : segments)
+    {
+        SpoolSegmentHeader *header = SEGMENT_HEADER(segment);
+
+        if (header->readOffset < header->writeOffset)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Spool::size()
+{
+    return totalBytes;
+}
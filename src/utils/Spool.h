@@ -0,0 +1,170 @@
+/*
+ * File: Spool.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_SPOOL
+#define SRC_UTILS_SPOOL
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief The default size of a Spool segment file
+ */
+#ifndef SPOOL_SEGMENT_SIZE
+#define SPOOL_SEGMENT_SIZE (1024 * 1024)
+#endif
+
+/**
+ * @brief A disk backed, append only queue of encoded payloads and their topics.
+ * Records are written into fixed size segment files that are memory mapped while the Spool is open.
+ * Segments are removed once all of their records have been replayed, and the oldest segments are
+ * dropped when the Spool grows beyond its size cap. The read and write positions are kept within
+ * each segment, so spooled records survive a restart.
+ */
+class Spool
+{
+private:
+    typedef struct
+    {
+        uint64_t index;
+        int file;
+        uint8_t *map;
+        size_t length;
+    } Segment;
+
+    std::string directory;
+    size_t maxBytes = 0;
+    size_t totalBytes = 0;
+    uint64_t nextIndex = 0;
+    std::deque<Segment> segments;
+
+    // The record returned by the last peek, which is the only record pop removes
+    bool peeked = false;
+    uint64_t peekedIndex = 0;
+    uint64_t peekedOffset = 0;
+
+    /**
+     * @brief Builds the path of a segment file
+     *
+     * @param index The index of the segment
+     * @return std::string
+     */
+    std::string segmentPath(uint64_t index);
+    /**
+     * @brief Maps an existing segment file
+     *
+     * @param index The index of the segment
+     * @return int 0 on success, -1 if the segment is invalid
+     */
+    int loadSegment(uint64_t index);
+    /**
+     * @brief Creates a new segment file large enough to hold a record
+     *
+     * @param recordLength The length of the record that will be appended
+     * @return int 0 on success, -1 on failure
+     */
+    int createSegment(size_t recordLength);
+    /**
+     * @brief Unmaps the oldest segment and deletes its file
+     */
+    void removeSegment();
+
+public:
+    Spool(){};
+    ~Spool();
+
+    Spool(const Spool &) = delete;
+    Spool &operator=(const Spool &) = delete;
+
+    /**
+     * @brief Opens a Spool in a directory, loading any records left from a previous run.
+     *
+     * @param directory The directory the segment files are stored in. Created if it does not exist.
+     * @param maxBytes The maximum size of all segment files
+     * @return int 0 on success, -1 on failure
+     */
+    int open(const char *directory, size_t maxBytes);
+    /**
+     * @brief Unmaps all segments, keeping any unreplayed records on disk
+     */
+    void close();
+    /**
+     * @brief Whether the Spool has been opened
+     *
+     * @return true
+     * @return false
+     */
+    bool isOpen();
+    /**
+     * @brief Appends a record to the Spool. If the Spool is full the oldest records are dropped.
+     *
+     * @param topic The topic the payload is published on
+     * @param payload The encoded payload
+     * @param length The length of the payload
+     * @return int 0 on success, -1 on failure
+     */
+    int append(std::string_view topic, const uint8_t *payload, size_t length);
+    /**
+     * @brief Gets the oldest record in the Spool without removing it.
+     * The record remains valid until it is popped or more records are appended.
+     * Appending can drop the segment holding the record to stay within the size cap, in which case it is not popped.
+     *
+     * @param topic The topic of the record
+     * @param payload The encoded payload of the record
+     * @param length The length of the payload
+     * @return true A record was found
+     * @return false The Spool is empty
+     */
+    bool peek(std::string_view &topic, const uint8_t *&payload, size_t &length);
+    /**
+     * @brief Removes the record returned by the last peek from the Spool.
+     * Nothing is removed if the record has already been dropped to make room for newer records.
+     */
+    void pop();
+    /**
+     * @brief Whether the Spool has no records to replay
+     *
+     * @return true
+     * @return false
+     */
+    bool isEmpty();
+    /**
+     * @brief The size of all segment files used by the Spool
+     *
+     * @return size_t
+     */
+    size_t size();
+};
+
+#endif /* SRC_UTILS_SPOOL */
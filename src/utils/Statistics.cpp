@@ -0,0 +1,129 @@
+/*
+ * File: Statistics.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "Statistics.h"
+
+void StatisticsGauge::set(uint64_t value)
+{
+    this->value.store(value, std::memory_order_relaxed);
+
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+size_t StatisticsHistogram::bucketOf(uint64_t value)
+{
+    size_t bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+    return bucket < STATISTICS_HISTOGRAM_BUCKETS ? bucket : STATISTICS_HISTOGRAM_BUCKETS - 1;
+}
+
+void StatisticsHistogram::record(uint64_t value)
+{
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t StatisticsHistogram::getCount() const
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+uint64_t StatisticsHistogram::getSum() const
+{
+    return sum.load(std::memory_order_relaxed);
+}
+
+uint64_t StatisticsHistogram::getMax() const
+{
+    return max.load(std::memory_order_relaxed);
+}
+
+uint64_t StatisticsHistogram::getMean() const
+{
+    uint64_t count = getCount();
+    return count > 0 ? getSum() / count : 0;
+}
+
+uint64_t StatisticsHistogram::getBucket(size_t bucket) const
+{
+    return bucket < STATISTICS_HISTOGRAM_BUCKETS ? buckets[bucket].load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t StatisticsHistogram::getPercentile(double percentile) const
+{
+    uint64_t total = 0;
+    for (auto &bucket : buckets)
+    {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    // The rank of the value at the percentile, counting from 1
+    uint64_t rank = (uint64_t)(percentile * total);
+    rank = rank < 1 ? 1 : (rank > total ? total : rank);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < STATISTICS_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            uint64_t upper = i == 0 ? 0 : (1ULL << i) - 1;
+            uint64_t max = getMax();
+            return upper < max ? upper : max;
+        }
+    }
+
+    return getMax();
+}
+
+void StatisticsHistogram::reset()
+{
+    for (auto &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
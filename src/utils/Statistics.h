@@ -0,0 +1,238 @@
+/*
+ * File: Statistics.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_STATISTICS
+#define SRC_UTILS_STATISTICS
+
+#include <atomic>
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The number of buckets in a StatisticsHistogram. Bucket i holds values below 2^i,
+ * so with microsecond values the last bucket holds anything from 35 minutes upwards.
+ */
+#ifndef STATISTICS_HISTOGRAM_BUCKETS
+#define STATISTICS_HISTOGRAM_BUCKETS 32
+#endif
+
+/**
+ * @brief Monotonic time in microseconds used for measuring latencies
+ *
+ * @return uint64_t
+ */
+inline uint64_t statisticsTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief A counter that can be incremented from any thread without locking
+ */
+class StatisticsCounter
+{
+private:
+    std::atomic<uint64_t> value = 0;
+
+public:
+    /**
+     * @brief Adds to the counter
+     *
+     * @param amount
+     */
+    void add(uint64_t amount = 1)
+    {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    /**
+     * @brief Get the value of the counter
+     *
+     * @return uint64_t
+     */
+    uint64_t get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief Resets the counter to 0
+     */
+    void reset()
+    {
+        value.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief A value that can be set from any thread without locking, keeping track of the largest value it was set to
+ */
+class StatisticsGauge
+{
+private:
+    std::atomic<uint64_t> value = 0;
+    std::atomic<uint64_t> max = 0;
+
+public:
+    /**
+     * @brief Sets the value of the gauge
+     *
+     * @param value
+     */
+    void set(uint64_t value);
+    /**
+     * @brief Get the current value of the gauge
+     *
+     * @return uint64_t
+     */
+    uint64_t get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief Get the largest value the gauge has been set to
+     *
+     * @return uint64_t
+     */
+    uint64_t getMax() const
+    {
+        return max.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief Resets the largest value to the current value
+     */
+    void reset()
+    {
+        max.store(get(), std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief A histogram with power of two bucket sizes that can be recorded to from any thread without locking.
+ * Bucket 0 holds zeroes and bucket i holds values in the range [2^(i - 1), 2^i), so percentiles are accurate to within a factor of two.
+ */
+class StatisticsHistogram
+{
+private:
+    std::atomic<uint64_t> buckets[STATISTICS_HISTOGRAM_BUCKETS] = {};
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> sum = 0;
+    std::atomic<uint64_t> max = 0;
+
+public:
+    /**
+     * @brief Records a value
+     *
+     * @param value
+     */
+    void record(uint64_t value);
+    /**
+     * @brief Get the number of values recorded
+     *
+     * @return uint64_t
+     */
+    uint64_t getCount() const;
+    /**
+     * @brief Get the sum of all values recorded
+     *
+     * @return uint64_t
+     */
+    uint64_t getSum() const;
+    /**
+     * @brief Get the largest value recorded
+     *
+     * @return uint64_t
+     */
+    uint64_t getMax() const;
+    /**
+     * @brief Get the mean of all values recorded
+     *
+     * @return uint64_t
+     */
+    uint64_t getMean() const;
+    /**
+     * @brief Get the number of values recorded in a bucket
+     *
+     * @param bucket
+     * @return uint64_t
+     */
+    uint64_t getBucket(size_t bucket) const;
+    /**
+     * @brief Get an upper bound on a percentile of the recorded values
+     *
+     * @param percentile The percentile in the range [0, 1]
+     * @return uint64_t The upper bound of the bucket holding the percentile, limited to the largest value recorded
+     */
+    uint64_t getPercentile(double percentile) const;
+    /**
+     * @brief Clears all recorded values
+     */
+    void reset();
+
+    /**
+     * @brief Get the bucket a value is recorded in
+     *
+     * @param value
+     * @return size_t
+     */
+    static size_t bucketOf(uint64_t value);
+};
+
+/**
+ * @brief Statistics on the publishes made by a SparkplugClient. Latencies are in microseconds.
+ */
+typedef struct
+{
+    StatisticsCounter published;
+    StatisticsCounter delivered;
+    StatisticsCounter undelivered;
+    StatisticsCounter retries;
+    StatisticsCounter bytesPublished;
+    StatisticsGauge queueDepth;
+    StatisticsHistogram queueLatency;
+    StatisticsHistogram deliveryLatency;
+    StatisticsHistogram encodeTime;
+    StatisticsHistogram payloadSize;
+} ClientStatistics;
+
+/**
+ * @brief Statistics on the execution of a Node. Times are in microseconds.
+ */
+typedef struct
+{
+    StatisticsCounter publishRequests;
+    StatisticsCounter eventsProcessed;
+    StatisticsCounter eventsOverflowed;
+    StatisticsHistogram executeTime;
+} NodeStatistics;
+
+#endif /* SRC_UTILS_STATISTICS */
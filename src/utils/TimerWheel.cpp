@@ -0,0 +1,244 @@
+/*
+ * File: TimerWheel.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "TimerWheel.h"
+#include <string.h>
+
+TimerWheel::TimerWheel(uint64_t now)
+{
+    memset(slots, 0, sizeof(slots));
+    memset(counts, 0, sizeof(counts));
+    current = now;
+}
+
+void TimerWheel::reset(uint64_t now)
+{
+    for (auto &level : slots)
+    {
+        for (auto &slot : level)
+        {
+            for (Timer *timer = slot; timer != nullptr;)
+            {
+                Timer *next = timer->next;
+                timer->next = timer->previous = nullptr;
+                timer->slot = nullptr;
+                timer = next;
+            }
+            slot = nullptr;
+        }
+    }
+
+    memset(counts, 0, sizeof(counts));
+    current = now;
+}
+
+void TimerWheel::insert(Timer *timer)
+{
+    uint64_t delay = timer->due > current ? timer->due - current : 0;
+
+    // Timers beyond the range of the wheel are held in the top level, and placed again once they cascade
+    uint64_t placed = current + (delay > MAX_DELAY ? MAX_DELAY : delay);
+
+    size_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delay >= (1ULL << (SLOT_BITS * (level + 1))))
+    {
+        level++;
+    }
+
+    Timer **slot = &slots[level][(placed >> (SLOT_BITS * level)) & MASK];
+
+    timer->previous = nullptr;
+    timer->next = *slot;
+    if (*slot != nullptr)
+    {
+        (*slot)->previous = timer;
+    }
+    *slot = timer;
+
+    timer->slot = slot;
+    timer->level = level;
+    counts[level]++;
+}
+
+void TimerWheel::remove(Timer *timer)
+{
+    if (timer->previous != nullptr)
+    {
+        timer->previous->next = timer->next;
+    }
+    else
+    {
+        *timer->slot = timer->next;
+    }
+
+    if (timer->next != nullptr)
+    {
+        timer->next->previous = timer->previous;
+    }
+
+    counts[timer->level]--;
+    timer->next = timer->previous = nullptr;
+    timer->slot = nullptr;
+}
+
+void TimerWheel::cascade(size_t level)
+{
+    if (level >= TIMER_WHEEL_LEVELS)
+    {
+        return;
+    }
+
+    size_t index = (current >> (SLOT_BITS * level)) & MASK;
+    Timer *timer = slots[level][index];
+    slots[level][index] = nullptr;
+
+    while (timer != nullptr)
+    {
+        Timer *next = timer->next;
+        counts[level]--;
+        insert(timer);
+        timer = next;
+    }
+
+    if (index == 0)
+    {
+        cascade(level + 1);
+    }
+}
+
+void TimerWheel::schedule(Timer *timer, uint64_t due)
+{
+    if (timer->isScheduled())
+    {
+        remove(timer);
+    }
+
+    timer->due = due;
+    insert(timer);
+}
+
+void TimerWheel::cancel(Timer *timer)
+{
+    if (timer->isScheduled())
+    {
+        remove(timer);
+    }
+}
+
+TimerWheel::Timer *TimerWheel::advance(uint64_t now)
+{
+    Timer *expired = nullptr;
+    Timer **tail = &expired;
+
+    while (current <= now)
+    {
+        Timer *&slot = slots[0][current & MASK];
+
+        while (slot != nullptr)
+        {
+            Timer *timer = slot;
+            remove(timer);
+            *tail = timer;
+            tail = &timer->next;
+        }
+
+        uint64_t next = current + 1;
+
+        // With nothing held in the lowest level, skip straight to the next slot that needs to cascade
+        if (counts[0] == 0)
+        {
+            uint64_t skip = nextDue();
+            skip = skip < now + 1 ? skip : now + 1;
+            next = skip > next ? skip : next;
+        }
+
+        current = next;
+
+        if ((current & MASK) == 0)
+        {
+            cascade(1);
+        }
+    }
+
+    return expired;
+}
+
+uint64_t TimerWheel::nextDue()
+{
+    if (counts[0] > 0)
+    {
+        // Every timer in the lowest level is due within a rotation of the current tick
+        for (uint64_t i = 0; i < SLOTS; i++)
+        {
+            if (slots[0][(current + i) & MASK] != nullptr)
+            {
+                return current + i;
+            }
+        }
+    }
+
+    uint64_t nextDue = UINT64_MAX;
+
+    for (size_t level = 1; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        if (counts[level] == 0)
+        {
+            continue;
+        }
+
+        size_t shift = SLOT_BITS * level;
+        uint64_t base = current >> shift;
+
+        for (uint64_t i = 1; i <= SLOTS; i++)
+        {
+            if (slots[level][(base + i) & MASK] != nullptr)
+            {
+                uint64_t cascadeTick = (base + i) << shift;
+                nextDue = cascadeTick < nextDue ? cascadeTick : nextDue;
+                break;
+            }
+        }
+    }
+
+    return nextDue;
+}
+
+bool TimerWheel::isEmpty()
+{
+    for (auto count : counts)
+    {
+        if (count > 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+/*
+ * File: TimerWheel.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_TIMERWHEEL
+#define SRC_UTILS_TIMERWHEEL
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The number of levels in a TimerWheel. Each level covers 64 times the range of the level below it,
+ * with four levels and a millisecond tick timers up to 4.6 hours ahead are placed directly.
+ */
+#ifndef TIMER_WHEEL_LEVELS
+#define TIMER_WHEEL_LEVELS 4
+#endif
+
+/**
+ * @brief A hierarchical timer wheel for scheduling timers at a tick resolution.
+ * Timers are intrusive, so scheduling and cancelling never allocate and take constant time.
+ * Timers due soon are held in the lowest level, which has a slot per tick. Timers further out are held in
+ * coarser levels and cascade down as the wheel advances towards them.
+ * Not thread safe.
+ */
+class TimerWheel
+{
+public:
+    /**
+     * @brief A timer that can be scheduled on a TimerWheel. Extend to attach data to the timer.
+     */
+    struct Timer
+    {
+        Timer *next = nullptr;
+        Timer *previous = nullptr;
+        Timer **slot = nullptr;
+        size_t level = 0;
+        uint64_t due = 0;
+
+        /**
+         * @brief Whether the timer is scheduled on a TimerWheel
+         *
+         * @return true
+         * @return false
+         */
+        bool isScheduled() { return slot != nullptr; }
+    };
+
+private:
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;
+    static constexpr uint64_t MASK = SLOTS - 1;
+    static constexpr uint64_t MAX_DELAY = (1ULL << (SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1;
+
+    Timer *slots[TIMER_WHEEL_LEVELS][SLOTS];
+    size_t counts[TIMER_WHEEL_LEVELS];
+    uint64_t current;
+
+    /**
+     * @brief Places a timer in the slot matching its due time
+     *
+     * @param timer
+     */
+    void insert(Timer *timer);
+    /**
+     * @brief Removes a timer from the slot it is held in
+     *
+     * @param timer
+     */
+    void remove(Timer *timer);
+    /**
+     * @brief Moves the timers of the current slot of a level down into the lower levels.
+     * Cascades the next level as well when the level has wrapped around.
+     *
+     * @param level
+     */
+    void cascade(size_t level);
+
+public:
+    /**
+     * @brief Construct a new TimerWheel
+     *
+     * @param now The current tick
+     */
+    TimerWheel(uint64_t now = 0);
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    /**
+     * @brief Removes all timers and sets the current tick
+     *
+     * @param now The current tick
+     */
+    void reset(uint64_t now);
+    /**
+     * @brief Schedules a timer. A timer that is already scheduled is moved to the new due tick.
+     * Timers due on a tick the wheel has already advanced past expire on the next tick.
+     *
+     * @param timer
+     * @param due The tick the timer expires on
+     */
+    void schedule(Timer *timer, uint64_t due);
+    /**
+     * @brief Cancels a scheduled timer
+     *
+     * @param timer
+     */
+    void cancel(Timer *timer);
+    /**
+     * @brief Advances the wheel, expiring all timers due up to and including the tick.
+     *
+     * @param now The current tick
+     * @return Timer* The expired timers in due order, linked through Timer::next. Expired timers are no longer scheduled,
+     * so the next timer must be read before an expired timer is scheduled again.
+     */
+    Timer *advance(uint64_t now);
+    /**
+     * @brief The tick the wheel next needs to be advanced on. This is the due tick of the next timer,
+     * or the tick a coarser level next cascades on if no timers are held in the lowest level.
+     *
+     * @return uint64_t The tick, or UINT64_MAX if no timers are scheduled
+     */
+    uint64_t nextDue();
+    /**
+     * @brief Whether no timers are scheduled
+     *
+     * @return true
+     * @return false
+     */
+    bool isEmpty();
+};
+
+#endif /* SRC_UTILS_TIMERWHEEL */
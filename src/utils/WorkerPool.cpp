@@ -0,0 +1,134 @@
+/*
+ * File: WorkerPool.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "WorkerPool.h"
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+
+using namespace std;
+
+WorkerPool::WorkerPool()
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::stop()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    threads.clear();
+    stopping = false;
+}
+
+void WorkerPool::resize(size_t count)
+{
+    stop();
+
+    threads.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        threads.emplace_back(&WorkerPool::work, this, i, generation);
+    }
+}
+
+size_t WorkerPool::concurrency()
+{
+    return threads.size() + 1;
+}
+
+void WorkerPool::work(size_t index, size_t lastGeneration)
+{
+    for (;;)
+    {
+        const function<void(size_t)> *current;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [this, lastGeneration]
+                                { return stopping || generation != lastGeneration; });
+
+            if (stopping)
+            {
+                return;
+            }
+
+            lastGeneration = generation;
+            current = task;
+        }
+
+        (*current)(index);
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            pending--;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+void WorkerPool::run(const function<void(size_t)> &task)
+{
+    if (threads.empty())
+    {
+        task(0);
+        return;
+    }
+
+    {
+        lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        pending = threads.size();
+        generation++;
+    }
+    startCondition.notify_all();
+
+    // The calling thread takes the last share of the work rather than idling
+    task(threads.size());
+
+    unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]
+                       { return pending == 0; });
+    this->task = nullptr;
+}
+
+#endif
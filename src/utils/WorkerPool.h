@@ -0,0 +1,102 @@
+/*
+ * File: WorkerPool.h
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#ifndef SRC_UTILS_WORKERPOOL
+#define SRC_UTILS_WORKERPOOL
+
+#include <functional>
+#include <stddef.h>
+#include <vector>
+#include <mutex>
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+#include <condition_variable>
+#include <thread>
+
+/**
+ * @brief A fixed set of threads that run a task in parallel with the calling thread.
+ * The task is given the index of the thread running it, the calling thread always runs the last index.
+ * Each run blocks until every thread has finished the task, so the task may safely reference data owned by the caller.
+ */
+class WorkerPool
+{
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    const std::function<void(size_t)> *task = nullptr;
+    size_t generation = 0;
+    size_t pending = 0;
+    bool stopping = false;
+
+    /**
+     * @brief The loop run by each thread in the pool
+     *
+     * @param index The index passed to the task
+     * @param lastGeneration The generation of the last task that was run before the thread started
+     */
+    void work(size_t index, size_t lastGeneration);
+    /**
+     * @brief Stops and joins all the threads in the pool
+     */
+    void stop();
+
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * @brief Sets the number of threads in the pool. Existing threads are joined before the new threads are started.
+     *
+     * @param count The number of threads, 0 runs every task on the calling thread
+     */
+    void resize(size_t count);
+    /**
+     * @brief The number of parallel runs of a task, including the calling thread
+     *
+     * @return size_t
+     */
+    size_t concurrency();
+    /**
+     * @brief Runs a task on every thread in the pool and the calling thread, returning once all have finished.
+     *
+     * @param task The task to run, called with an index in the range [0, concurrency())
+     */
+    void run(const std::function<void(size_t)> &task);
+};
+
+#endif
+
+#endif /* SRC_UTILS_WORKERPOOL */
@@ -36,12 +36,17 @@
 #include "utils/MockTimeManager.h"
 
 #include "metrics/simple/Int32Metric.h"
+#include "metrics/simple/DoubleMetric.h"
+#include "metrics/simple/BooleanMetric.h"
 #include "metrics/simple/StringMetric.h"
+#include "metrics/complex/DataSetMetric.h"
 
 #include "properties/simple/UInt8Property.h"
 #include "properties/simple/StringProperty.h"
 #include "properties/complex/PropertySet.h"
 
+#include "utils/Protobuf.h"
+
 TEST(SimpleMetric, TestSimpleDirty)
 {
     auto testMetric = Int32Metric::create("MetricName", 20);
@@ -75,6 +80,148 @@ TEST(SimpleMetric, TestSimpleDirty)
     EXPECT_EQ(testMetric->getValue(), newValue);
 }
 
+TEST(SimpleMetric, TestInlineStorage)
+{
+    auto doubleMetric = DoubleMetric::create("DoubleMetric", 1.5);
+    auto boolMetric = BooleanMetric::create("BoolMetric", false);
+
+    // Fixed width values live within the metric rather than in a separate allocation
+    uint8_t *doubleStart = (uint8_t *)doubleMetric.get();
+    uint8_t *doubleData = (uint8_t *)doubleMetric->getData();
+    EXPECT_TRUE(doubleData >= doubleStart && doubleData < doubleStart + sizeof(DoubleMetric));
+
+    EXPECT_EQ(doubleMetric->getValue(), 1.5);
+    EXPECT_EQ(*(double *)doubleMetric->getData(), 1.5);
+
+    doubleMetric->setValue(1.5);
+    EXPECT_FALSE(doubleMetric->isDirty());
+
+    doubleMetric->setValue(2.25);
+    EXPECT_TRUE(doubleMetric->isDirty());
+    EXPECT_EQ(*(double *)doubleMetric->getData(), 2.25);
+
+    doubleMetric->published();
+    EXPECT_FALSE(doubleMetric->isDirty());
+
+    boolMetric->setValue(false);
+    EXPECT_FALSE(boolMetric->isDirty());
+
+    boolMetric->setValue(true);
+    EXPECT_TRUE(boolMetric->isDirty());
+    EXPECT_TRUE(boolMetric->getValue());
+}
+
+TEST(SimpleMetric, TestDeadband)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+
+    auto testMetric = DoubleMetric::create("MetricName", 100.0);
+    testMetric->setDeadband(1.0, 2.0);
+
+    // Within the absolute deadband
+    testMetric->setValue(100.5);
+    EXPECT_FALSE(testMetric->isDirty());
+    EXPECT_EQ(testMetric->getValue(), 100.5);
+
+    // Exceeds the absolute deadband, but not the percentage deadband
+    testMetric->setValue(101.5);
+    EXPECT_FALSE(testMetric->isDirty());
+
+    // Deadbands are measured from the last published value, so small steps still accumulate
+    testMetric->setValue(102.5);
+    EXPECT_TRUE(testMetric->isDirty());
+
+    testMetric->published();
+    EXPECT_FALSE(testMetric->isDirty());
+
+    testMetric->setDeadband(0);
+    testMetric->setMinimumInterval(1000);
+
+    mockManager.setTime(500);
+    testMetric->setValue(110.0);
+    EXPECT_FALSE(testMetric->isDirty()) << "Minimum interval has not passed since the last report";
+
+    mockManager.setTime(1000);
+    testMetric->setValue(111.0);
+    EXPECT_TRUE(testMetric->isDirty());
+
+    testMetric->published();
+
+    mockManager.setTime(1500);
+    testMetric->setValue(112.0);
+    EXPECT_FALSE(testMetric->isDirty());
+
+    mockManager.setTime(2000);
+    testMetric->setValue(112.0);
+    EXPECT_TRUE(testMetric->isDirty()) << "A suppressed change is published once the interval has passed";
+
+    testMetric->published();
+
+    // A birth publishes the current value, so deadbands are measured from it afterwards
+    testMetric->setMinimumInterval(0);
+    testMetric->setDeadband(5.0);
+    testMetric->setValue(115.0);
+    EXPECT_FALSE(testMetric->isDirty());
+    testMetric->published();
+
+    testMetric->setValue(118.0);
+    EXPECT_FALSE(testMetric->isDirty()) << "Within the deadband of the value published in the birth";
+    testMetric->setValue(120.5);
+    EXPECT_TRUE(testMetric->isDirty());
+
+    TimeManager::setInstance(NULL);
+}
+
+TEST(SimpleMetric, TestHistory)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+
+    auto testMetric = Int32Metric::create("MetricName", 0);
+    EXPECT_EQ(testMetric->enableHistory(2), 0);
+
+    for (int i = 1; i <= 4; i++)
+    {
+        mockManager.setTime(i * 100);
+        testMetric->setValue(i);
+    }
+
+    // The first value is dropped as the history only holds two samples
+    testMetric->addToPayload(&payload);
+    ASSERT_EQ(payload.metrics_count, 3);
+
+    EXPECT_TRUE(payload.metrics[0].is_historical);
+    EXPECT_EQ(payload.metrics[0].value.int_value, 2);
+    EXPECT_EQ(payload.metrics[0].timestamp, 200);
+
+    EXPECT_TRUE(payload.metrics[1].is_historical);
+    EXPECT_EQ(payload.metrics[1].value.int_value, 3);
+    EXPECT_EQ(payload.metrics[1].timestamp, 300);
+
+    EXPECT_FALSE(payload.metrics[2].is_historical);
+    EXPECT_EQ(payload.metrics[2].value.int_value, 4);
+    EXPECT_EQ(payload.metrics[2].timestamp, 400);
+
+    free_payload(&payload);
+    get_next_payload(&payload);
+
+    testMetric->published();
+
+    mockManager.setTime(500);
+    testMetric->setValue(5);
+
+    testMetric->addToPayload(&payload);
+    ASSERT_EQ(payload.metrics_count, 1);
+    EXPECT_FALSE(payload.metrics[0].is_historical);
+    EXPECT_EQ(payload.metrics[0].value.int_value, 5);
+
+    free_payload(&payload);
+    TimeManager::setInstance(NULL);
+}
+
 TEST(SimpleMetric, TestStringDirty)
 {
     auto testMetric = StringMetric::create("MetricName", "SomeString");
@@ -273,4 +420,253 @@ TEST(SimpleMetric, TestAddToPayloadWithProperties)
     TimeManager::reset();
 
     free_payload(&payload);
-}
\ No newline at end of file
+}
+
+TEST(SimpleMetric, TestStreamEncode)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+
+    auto enabled = UInt8Property::create("ON", 1);
+    auto stringMetric = StringMetric::create("StringMetric", "MyString");
+    stringMetric->addProperties({
+        PropertySet::create("enum",
+                            {
+                                UInt8Property::create("OFF", 0),
+                                enabled,
+                            }),
+        StringProperty::create("trueText", "Active"),
+    });
+
+    auto intMetric = Int32Metric::create("IntMetric", -1);
+    intMetric->setAlias(5);
+    EXPECT_EQ(intMetric->enableHistory(4), 0);
+
+    auto doubleMetric = DoubleMetric::create("DoubleMetric", 1.5);
+    auto booleanMetric = BooleanMetric::create("BooleanMetric", true);
+
+    // Metrics too large to encode on the stack are sized before they are written
+    auto longMetric = StringMetric::create("LongMetric", std::string(1000, 'x'));
+
+    std::vector<std::shared_ptr<Metric>> metrics = {stringMetric, intMetric, doubleMetric, booleanMetric, longMetric};
+
+    // Streamed metrics encode the same as the struct form of the metrics
+    auto expectEncoding = [&metrics](bool isBirth)
+    {
+        org_eclipse_tahu_protobuf_Payload payload;
+        memset(&payload, 0, sizeof(payload));
+        for (auto &metric : metrics)
+        {
+            metric->addToPayload(&payload, isBirth);
+        }
+        std::vector<uint8_t> expected(encode_payload(NULL, 0, &payload));
+        EXPECT_EQ(encode_payload(expected.data(), expected.size(), &payload), (ssize_t)expected.size());
+        free_payload(&payload);
+
+        std::vector<uint8_t> buffer;
+        pb_ostream_t stream = protobufStreamFromVector(buffer);
+        for (auto &metric : metrics)
+        {
+            EXPECT_EQ(metric->encode(&stream, isBirth), 0);
+        }
+        EXPECT_EQ(buffer, expected);
+    };
+
+    mockManager.setTime(50);
+    expectEncoding(true);
+
+    mockManager.setTime(100);
+    intMetric->setValue(-2);
+    mockManager.setTime(200);
+    intMetric->setValue(3);
+    doubleMetric->setValue(-0.25);
+
+    // Only the dirty property of the set is included outside of a birth
+    enabled->setValue(2);
+    stringMetric->setValue("Changed");
+    longMetric->setValue(std::string(2000, 'y'));
+    expectEncoding(false);
+
+    TimeManager::reset();
+}
+
+TEST(DataSetMetric, TestRows)
+{
+    EXPECT_EQ(DataSetMetric::create("Invalid", {{"Column", DATA_SET_DATA_TYPE_UNKNOWN}}), nullptr);
+
+    auto dataSet = DataSetMetric::create("DataSet", {
+                                                        {"Count", DATA_SET_DATA_TYPE_INT16},
+                                                        {"Reading", DATA_SET_DATA_TYPE_DOUBLE},
+                                                        {"Label", DATA_SET_DATA_TYPE_STRING},
+                                                    });
+    ASSERT_NE(dataSet, nullptr);
+    EXPECT_EQ(dataSet->getColumnCount(), 3);
+    EXPECT_FALSE(dataSet->isDirty());
+
+    EXPECT_EQ(dataSet->appendRow(-3, 1.5, "first"), 0);
+    EXPECT_EQ(dataSet->appendRow(70000, 2.5f, std::string("second")), 0);
+    EXPECT_TRUE(dataSet->isDirty());
+
+    // Rows must have a value of a matching kind for every column
+    EXPECT_EQ(dataSet->appendRow(1, 2.0), -1);
+    EXPECT_EQ(dataSet->appendRow(1, "two", "three"), -1);
+    EXPECT_EQ(dataSet->replaceRow(2, 1, 2.0, "three"), -1);
+    EXPECT_EQ(dataSet->setCell(0, 2, 4), -1);
+    EXPECT_EQ(dataSet->getRowCount(), 2);
+
+    // Numbers are converted to the type of their column
+    EXPECT_EQ(dataSet->getCell<int>(0, 0), -3);
+    EXPECT_EQ(dataSet->getCell<int>(1, 0), (int16_t)70000);
+    EXPECT_EQ(dataSet->getCell<double>(1, 1), 2.5);
+    EXPECT_STREQ(dataSet->getString(0, 2), "first");
+    EXPECT_STREQ(dataSet->getString(1, 2), "second");
+    EXPECT_EQ(dataSet->getString(1, 1), nullptr);
+
+    dataSet->published();
+    EXPECT_FALSE(dataSet->isDirty());
+    EXPECT_EQ(dataSet->getDirtyRowCount(), 0);
+
+    EXPECT_EQ(dataSet->replaceRow(1, 5, 3.5, "a much longer second label"), 0);
+    EXPECT_EQ(dataSet->setCell(0, 2, "1st"), 0);
+    EXPECT_TRUE(dataSet->isDirty());
+    EXPECT_EQ(dataSet->getDirtyRowCount(), 2);
+    EXPECT_EQ(dataSet->getCell<int>(1, 0), 5);
+    EXPECT_STREQ(dataSet->getString(0, 2), "1st");
+    EXPECT_STREQ(dataSet->getString(1, 2), "a much longer second label");
+
+    dataSet->published();
+    EXPECT_EQ(dataSet->appendRow(6, 4.5, ""), 0);
+    EXPECT_FALSE(dataSet->isRowDirty(1));
+    EXPECT_TRUE(dataSet->isRowDirty(2));
+    EXPECT_STREQ(dataSet->getString(2, 2), "");
+
+    // Strings replaced many times do not grow the storage of their column without bound
+    for (int i = 0; i < 1000; i++)
+    {
+        EXPECT_EQ(dataSet->setCell(2, 2, std::string(i % 50, 'x')), 0);
+    }
+    EXPECT_EQ(dataSet->getString(2, 2), std::string(999 % 50, 'x'));
+    EXPECT_STREQ(dataSet->getString(1, 2), "a much longer second label");
+
+    // Strings can be copied from other cells of the same column, while the column grows and is compacted
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(dataSet->setCell(0, 2, ""), 0);
+        EXPECT_EQ(dataSet->setCell(0, 2, dataSet->getString(1, 2)), 0);
+        EXPECT_EQ(dataSet->setCell(2, 2, dataSet->getString(0, 2)), 0);
+        EXPECT_EQ(dataSet->setCell(1, 2, dataSet->getString(1, 2)), 0);
+    }
+    EXPECT_STREQ(dataSet->getString(0, 2), "a much longer second label");
+    EXPECT_STREQ(dataSet->getString(1, 2), "a much longer second label");
+    EXPECT_STREQ(dataSet->getString(2, 2), "a much longer second label");
+
+    // A cell can be replaced with a part of its own value
+    EXPECT_EQ(dataSet->setCell(1, 2, dataSet->getString(1, 2) + 7), 0);
+    EXPECT_STREQ(dataSet->getString(1, 2), "longer second label");
+
+    dataSet->clear();
+    EXPECT_EQ(dataSet->getRowCount(), 0);
+    EXPECT_EQ(dataSet->getDirtyRowCount(), 0);
+}
+
+TEST(DataSetMetric, TestEncode)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+
+    auto dataSet = DataSetMetric::create("DataSet", {
+                                                        {"Time", DATA_SET_DATA_TYPE_DATETIME},
+                                                        {"Count", DATA_SET_DATA_TYPE_INT8},
+                                                        {"Total", DATA_SET_DATA_TYPE_UINT32},
+                                                        {"Reading", DATA_SET_DATA_TYPE_FLOAT},
+                                                        {"Average", DATA_SET_DATA_TYPE_DOUBLE},
+                                                        {"Valid", DATA_SET_DATA_TYPE_BOOLEAN},
+                                                        {"Label", DATA_SET_DATA_TYPE_TEXT},
+                                                    });
+    dataSet->setAlias(3);
+
+    mockManager.setTime(50);
+    for (int i = 0; i < 20; i++)
+    {
+        EXPECT_EQ(dataSet->appendRow(1000 + i, -i, i * 100000, i * 0.5f, i * 0.25, i % 2 == 0, std::string(i * 10, 'a' + i)), 0);
+    }
+
+    // DataSets encode the same from their columns as from the struct form
+    auto expectEncoding = [&](bool isBirth)
+    {
+        org_eclipse_tahu_protobuf_Payload payload;
+        memset(&payload, 0, sizeof(payload));
+        dataSet->addToPayload(&payload, isBirth);
+        std::vector<uint8_t> expected(encode_payload(NULL, 0, &payload));
+        EXPECT_EQ(encode_payload(expected.data(), expected.size(), &payload), (ssize_t)expected.size());
+        free_payload(&payload);
+
+        std::vector<uint8_t> buffer;
+        pb_ostream_t stream = protobufStreamFromVector(buffer);
+        EXPECT_EQ(dataSet->encode(&stream, isBirth), 0);
+        EXPECT_EQ(buffer, expected);
+        return buffer;
+    };
+
+    std::vector<uint8_t> encoded = expectEncoding(true);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    memset(&payload, 0, sizeof(payload));
+    ASSERT_GE(decode_payload(&payload, encoded.data(), encoded.size()), 0);
+    ASSERT_EQ(payload.metrics_count, 1);
+    ASSERT_EQ(payload.metrics[0].which_value, org_eclipse_tahu_protobuf_Payload_Metric_dataset_value_tag);
+    org_eclipse_tahu_protobuf_Payload_DataSet *decoded = &payload.metrics[0].value.dataset_value;
+    EXPECT_EQ(decoded->num_of_columns, 7);
+    ASSERT_EQ(decoded->types_count, 7);
+    EXPECT_EQ(decoded->types[6], DATA_SET_DATA_TYPE_TEXT);
+    EXPECT_STREQ(decoded->columns[1], "Count");
+    ASSERT_EQ(decoded->rows_count, 20);
+    ASSERT_EQ(decoded->rows[7].elements_count, 7);
+    EXPECT_EQ(decoded->rows[7].elements[0].value.long_value, 1007);
+    EXPECT_EQ((int32_t)decoded->rows[7].elements[1].value.int_value, -7);
+    EXPECT_EQ(decoded->rows[7].elements[2].value.int_value, 700000);
+    EXPECT_EQ(decoded->rows[7].elements[3].value.float_value, 3.5f);
+    EXPECT_EQ(decoded->rows[7].elements[4].value.double_value, 1.75);
+    EXPECT_FALSE(decoded->rows[7].elements[5].value.boolean_value);
+    EXPECT_EQ(std::string(decoded->rows[7].elements[6].value.string_value), std::string(70, 'h'));
+    free_payload(&payload);
+
+    // DataSets are too large to cache, so births are always encoded from the current rows
+    EXPECT_EQ(dataSet->enableBirthCache(true), -1);
+    std::vector<uint8_t> birth;
+    EXPECT_EQ(dataSet->appendBirth(birth, 50), 0);
+    EXPECT_EQ(dataSet->replaceRow(19, 0, 0, 0, 0.0f, 0.0, false, "replaced"), 0);
+    std::vector<uint8_t> changedBirth;
+    EXPECT_EQ(dataSet->appendBirth(changedBirth, 50), 0);
+    EXPECT_NE(changedBirth, birth);
+
+    expectEncoding(false);
+    dataSet->published();
+
+    // Changed rows make the DataSet dirty, and data messages carry the full table as hosts replace their copy
+    mockManager.setTime(100);
+    EXPECT_FALSE(dataSet->isDirty());
+    EXPECT_EQ(dataSet->setCell(4, 6, "changed"), 0);
+    EXPECT_EQ(dataSet->appendRow(2000, 1, 2, 3.0f, 4.0, true, "appended"), 0);
+    EXPECT_TRUE(dataSet->isDirty());
+    EXPECT_EQ(dataSet->getDirtyRowCount(), 2);
+    encoded = expectEncoding(false);
+
+    memset(&payload, 0, sizeof(payload));
+    ASSERT_GE(decode_payload(&payload, encoded.data(), encoded.size()), 0);
+    ASSERT_EQ(payload.metrics_count, 1);
+    EXPECT_EQ(payload.metrics[0].name, nullptr);
+    decoded = &payload.metrics[0].value.dataset_value;
+    ASSERT_EQ(decoded->rows_count, 21);
+    EXPECT_EQ(decoded->rows[0].elements[0].value.long_value, 1000);
+    EXPECT_STREQ(decoded->rows[4].elements[6].value.string_value, "changed");
+    EXPECT_STREQ(decoded->rows[20].elements[6].value.string_value, "appended");
+    free_payload(&payload);
+
+    dataSet->published();
+    EXPECT_EQ(dataSet->getDirtyRowCount(), 0);
+
+    expectEncoding(true);
+
+    TimeManager::reset();
+}
@@ -32,12 +32,19 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "mocks/MockSparkplugClient.h"
+#include "mocks/MockPahoClient.h"
 #include "Node.h"
+#include "metrics/simple/Int32Metric.h"
+#include "utils/PublishRequestPool.h"
+#include <filesystem>
+#include <thread>
 
 const char CLIENT_ADDRESS[] = "tcp://192.168.1.20:1883";
 const char CLIENT_CLIENT_ID[] = "unique_id";
 
+using ::testing::_;
 using ::testing::AtLeast;
+using ::testing::Gt;
 using ::testing::Mock;
 using ::testing::NotNull;
 using ::testing::Return;
@@ -268,10 +275,10 @@ TEST(NodeTests, executeHappyPrimaryTest)
     ASSERT_NE(requestedPublish, nullptr);
     EXPECT_EQ(requestedPublish->isBirth, true);
     EXPECT_EQ(requestedPublish->publisher, (Publishable *)&node);
-    EXPECT_STREQ(requestedPublish->topic.c_str(), "spBv1.0/GroupId/NBIRTH/NodeId");
+    EXPECT_STREQ(requestedPublish->topic->c_str(), "spBv1.0/GroupId/NBIRTH/NodeId");
 
     // We should expect our brocket to be requested to send this request
-    EXPECT_CALL(*mockClient, publishMessage(requestedPublish->topic, NotNull(), 32, &requestedPublish->token))
+    EXPECT_CALL(*mockClient, publishMessage(*requestedPublish->topic, NotNull(), 30, &requestedPublish->token))
         .WillOnce([mockClient](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
                   { return 0; });
 
@@ -365,10 +372,10 @@ TEST(NodeTests, executeHappyTest)
     ASSERT_NE(requestedPublish, nullptr);
     EXPECT_EQ(requestedPublish->isBirth, true);
     EXPECT_EQ(requestedPublish->publisher, (Publishable *)&node);
-    EXPECT_STREQ(requestedPublish->topic.c_str(), "spBv1.0/GroupId/NBIRTH/NodeId");
+    EXPECT_STREQ(requestedPublish->topic->c_str(), "spBv1.0/GroupId/NBIRTH/NodeId");
 
     // We should expect our brocket to be requested to send this request
-    EXPECT_CALL(*mockClient, publishMessage(requestedPublish->topic, NotNull(), 32, &requestedPublish->token))
+    EXPECT_CALL(*mockClient, publishMessage(*requestedPublish->topic, NotNull(), 30, &requestedPublish->token))
         .WillOnce([mockClient](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
                   { return 0; });
 
@@ -388,3 +395,1146 @@ TEST(NodeTests, executeHappyTest)
 
     EXPECT_EQ(node.execute(5), 5) << "No new data to publish, so timer should lock at 5";
 }
+
+TEST(NodeTests, processLargeRequest)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+
+    Device device = Device("Device", 5);
+
+    for (int i = 0; i < 100; i++)
+    {
+        device.addMetric(Int32Metric::create(("Metric/" + std::to_string(i)).c_str(), i));
+    }
+
+    std::string topic = "spBv1.0/GroupId/DBIRTH/NodeId/Device";
+    PublishRequest request(true, (Publishable *)&device, &topic, -1, 0);
+
+    // The birth is larger than the initial encode buffer, the client should grow the buffer and still encode the payload once
+    EXPECT_CALL(*mockClient, publishMessage(*request.topic, NotNull(), Gt(MAX_BUFFER_LENGTH), &request.token))
+        .Times(2)
+        .WillRepeatedly([](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                        {
+            org_eclipse_tahu_protobuf_Payload payload;
+            EXPECT_GE(decode_payload(&payload, buffer, length), 0);
+            EXPECT_EQ(payload.metrics_count, 100);
+            free_payload(&payload);
+            return 0; });
+
+    EXPECT_EQ(mockClient->processRequest(&request), 0);
+    EXPECT_EQ(mockClient->processRequest(&request), 0);
+}
+
+TEST(NodeTests, deviceCommandRouting)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([](PublishRequest *publishRequest)
+                                                                {
+        SparkplugClient::destroyRequest(publishRequest);
+        return 0; });
+
+    Device first = Device("First", 5);
+    Device second = Device("Second", 5);
+
+    auto firstMetric = Int32Metric::create("Metric", 0);
+    auto secondMetric = Int32Metric::create("Metric", 0);
+    first.addMetric(firstMetric);
+    second.addMetric(secondMetric);
+
+    int32_t firstValue = 0, secondValue = 0;
+    firstMetric->setCommandCallback([&firstValue](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                                    { firstValue = payload->value.int_value; });
+    secondMetric->setCommandCallback([&secondValue](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                                     { secondValue = payload->value.int_value; });
+
+    node.addDevice(&first);
+    node.addDevice(&second);
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    int32_t commandValue = 12;
+    init_metric(&command, "Metric", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[128];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    {
+        MessageEventStruct messageEvent = {
+            "spBv1.0/GroupId/DCMD/NodeId/Second", buffer, (int)length};
+
+        node.onEvent(mockClient, CLIENT_MESSAGE, &messageEvent);
+    }
+
+    {
+        // Device names that only share a prefix with a known device should not match
+        MessageEventStruct messageEvent = {
+            "spBv1.0/GroupId/DCMD/NodeId/Sec", buffer, (int)length};
+
+        node.onEvent(mockClient, CLIENT_MESSAGE, &messageEvent);
+    }
+
+    node.sync();
+
+    EXPECT_EQ(secondValue, 12);
+    EXPECT_EQ(firstValue, 0);
+}
+
+static int releasedMessages = 0;
+
+static void releaseTestMessage(void *message, char *topic)
+{
+    free(message);
+    free(topic);
+    releasedMessages++;
+}
+
+TEST(NodeTests, messageOwnership)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    releasedMessages = 0;
+
+    {
+        char *topic = strdup("spBv1.0/GroupId/NCMD/OtherNode");
+        void *payload = malloc(16);
+        memset(payload, 0, 16);
+
+        // Owned messages are moved into the queue, and released once dispatched
+        MessageEventStruct messageEvent(
+            topic, payload, 16, payload, topic, releaseTestMessage);
+
+        node.onEvent(NULL, CLIENT_MESSAGE, &messageEvent);
+        EXPECT_FALSE(messageEvent.isOwned());
+    }
+
+    EXPECT_EQ(releasedMessages, 0);
+
+    {
+        uint8_t payload[16] = {0};
+
+        // Borrowed messages are copied into the queue
+        MessageEventStruct messageEvent = {
+            "spBv1.0/GroupId/NCMD/OtherNode", payload, 16};
+
+        node.onEvent(NULL, CLIENT_MESSAGE, &messageEvent);
+        EXPECT_FALSE(messageEvent.isOwned());
+    }
+
+    node.sync();
+
+    EXPECT_EQ(releasedMessages, 1);
+}
+
+#ifdef CPP_SPARKPLUG_SPOOL
+TEST(NodeTests, spoolReplay)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cpp_sparkplug_node_spool_test";
+    std::filesystem::remove_all(directory);
+
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    vector<PublishRequest *> requests;
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([&requests](PublishRequest *publishRequest)
+                                                                {
+        requests.push_back(publishRequest);
+        return 0; });
+
+    Device device = Device("Device", 5);
+    auto metric = Int32Metric::create("Metric", 0);
+    device.addMetric(metric);
+    node.addDevice(&device);
+
+    ASSERT_EQ(node.enableSpool(directory.c_str(), 64 * 1024), 0);
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    // No client is active, so data is spooled
+    metric->setValue(42);
+    node.execute(10);
+    EXPECT_TRUE(requests.empty());
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    // Births are published before the spooled data is replayed
+    node.execute(0);
+    ASSERT_EQ(requests.size(), 3);
+    EXPECT_TRUE(requests[0]->isBirth);
+    EXPECT_TRUE(requests[1]->isBirth);
+
+    PublishRequest *replay = requests[2];
+    EXPECT_FALSE(replay->isBirth);
+    EXPECT_STREQ(replay->topic->c_str(), "spBv1.0/GroupId/DDATA/NodeId/Device");
+
+    std::vector<uint8_t> published;
+    EXPECT_CALL(*mockClient, publishMessage(*replay->topic, NotNull(), Gt(0), &replay->token))
+        .WillOnce([&published](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                  { published.assign(buffer, buffer + length);
+                    return 0; });
+    EXPECT_EQ(mockClient->processRequest(replay), 0);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, published.data(), published.size()), 0);
+    ASSERT_EQ(payload.metrics_count, 1);
+    EXPECT_TRUE(payload.metrics[0].is_historical);
+    EXPECT_EQ(payload.metrics[0].value.int_value, 42);
+    // Spooled metrics are named, as aliases do not survive a restart
+    EXPECT_STREQ(payload.metrics[0].name, "Metric");
+    EXPECT_FALSE(payload.metrics[0].has_alias);
+    free_payload(&payload);
+
+    for (auto request : requests)
+    {
+        node.onEvent(mockClient, CLIENT_DELIVERED, request->publisher);
+        SparkplugClient::destroyRequest(request);
+    }
+    requests.clear();
+
+    node.sync();
+    node.execute(0);
+
+    // The spool is empty once the replay was delivered
+    EXPECT_TRUE(requests.empty());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(NodeTests, spoolUndelivered)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cpp_sparkplug_node_undelivered_test";
+    std::filesystem::remove_all(directory);
+
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    vector<PublishRequest *> requests;
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([&requests](PublishRequest *publishRequest)
+                                                                {
+        requests.push_back(publishRequest);
+        return 0; });
+
+    Device device = Device("Device", 5);
+    auto metric = Int32Metric::create("Metric", 0);
+    device.addMetric(metric);
+    node.addDevice(&device);
+
+    ASSERT_EQ(node.enableSpool(directory.c_str(), 64 * 1024), 0);
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    // Undelivered births are not spooled
+    node.execute(0);
+    ASSERT_EQ(requests.size(), 2);
+    for (auto request : requests)
+    {
+        EXPECT_TRUE(request->isBirth);
+        mockClient->undeliver(request);
+    }
+    requests.clear();
+    node.sync();
+
+    metric->setValue(42);
+    node.execute(10);
+    ASSERT_EQ(requests.size(), 1);
+    PublishRequest *data = requests[0];
+    EXPECT_FALSE(data->isBirth);
+    EXPECT_EQ(mockClient->prepareRequest(data), 0);
+    requests.clear();
+
+    // The payload that failed to send is spooled, rather than the current value of the metric
+    metric->setValue(43);
+    mockClient->undeliver(data);
+    node.sync();
+
+    node.execute(10);
+    PublishRequest *replay = NULL;
+    for (auto request : requests)
+    {
+        if (request->publisher != (Publishable *)&device)
+        {
+            EXPECT_EQ(replay, nullptr);
+            replay = request;
+        }
+    }
+    ASSERT_NE(replay, nullptr);
+    EXPECT_FALSE(replay->isBirth);
+
+    std::vector<uint8_t> published;
+    EXPECT_CALL(*mockClient, publishMessage(*replay->topic, NotNull(), Gt(0), &replay->token))
+        .WillOnce([&published](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                  { published.assign(buffer, buffer + length);
+                    return 0; });
+    EXPECT_EQ(mockClient->processRequest(replay), 0);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, published.data(), published.size()), 0);
+    ASSERT_EQ(payload.metrics_count, 1);
+    EXPECT_TRUE(payload.metrics[0].is_historical);
+    EXPECT_EQ(payload.metrics[0].value.int_value, 42);
+    // Spooled metrics are named, as aliases do not survive a restart
+    EXPECT_STREQ(payload.metrics[0].name, "Metric");
+    EXPECT_FALSE(payload.metrics[0].has_alias);
+    free_payload(&payload);
+
+    for (auto request : requests)
+    {
+        SparkplugClient::destroyRequest(request);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+#endif
+
+TEST(NodeTests, sequenceAtSend)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+
+    Device first = Device("First", 5);
+    auto firstMetric = Int32Metric::create("Metric", 0);
+    first.addMetric(firstMetric);
+    firstMetric->setValue(1);
+
+    Device second = Device("Second", 5);
+    auto secondMetric = Int32Metric::create("Metric", 0);
+    second.addMetric(secondMetric);
+    secondMetric->setValue(2);
+
+    std::string firstTopic = "spBv1.0/GroupId/DDATA/NodeId/First";
+    std::string secondTopic = "spBv1.0/GroupId/DDATA/NodeId/Second";
+    PublishRequest firstRequest(false, (Publishable *)&first, &firstTopic, -1, 0);
+    PublishRequest secondRequest(false, (Publishable *)&second, &secondTopic, -1, 0);
+
+    // Payloads are encoded ahead of the send, without a sequence
+    ASSERT_EQ(mockClient->prepareRequest(&firstRequest), 0);
+    ASSERT_EQ(mockClient->prepareRequest(&secondRequest), 0);
+
+    size_t firstLength = firstRequest.encodedLength;
+    EXPECT_GT(firstLength, 0);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, firstRequest.encoded.data(), firstRequest.encodedLength), 0);
+    EXPECT_FALSE(payload.has_seq);
+    free_payload(&payload);
+
+    // Changes after the payload was encoded are not part of it
+    firstMetric->setValue(10);
+
+    std::vector<uint8_t> published;
+    auto capture = [&published](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+    { published.assign(buffer, buffer + length);
+      return 0; };
+
+    auto expectPublished = [&published](uint64_t sequence, int32_t value)
+    {
+        org_eclipse_tahu_protobuf_Payload payload;
+        ASSERT_GE(decode_payload(&payload, published.data(), published.size()), 0);
+        EXPECT_TRUE(payload.has_seq);
+        EXPECT_EQ(payload.seq, sequence);
+        ASSERT_EQ(payload.metrics_count, 1);
+        EXPECT_EQ(payload.metrics[0].value.int_value, value);
+        free_payload(&payload);
+    };
+
+    // Sequences follow the order payloads are sent in, not the order they were encoded in
+    EXPECT_CALL(*mockClient, publishMessage(secondTopic, NotNull(), Gt(0), &secondRequest.token)).WillOnce(capture);
+    EXPECT_EQ(mockClient->processRequest(&secondRequest), 0);
+    expectPublished(0, 2);
+
+    EXPECT_CALL(*mockClient, publishMessage(firstTopic, NotNull(), Gt(0), &firstRequest.token)).WillRepeatedly(capture);
+    EXPECT_EQ(mockClient->processRequest(&firstRequest), 0);
+    expectPublished(1, 1);
+
+    // A retry reuses the encoded payload with the sequence it was first sent with
+    EXPECT_EQ(mockClient->processRequest(&firstRequest), 0);
+    EXPECT_EQ(firstRequest.encodedLength, firstLength);
+    expectPublished(1, 1);
+}
+
+TEST(NodeTests, retryInFlight)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5,
+        .maxInflight = 2};
+
+    MockPahoClient *mockClient;
+
+    mockClient = (MockPahoClient *)node.addClient<MockPahoClient>(&clientOptions);
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+
+    // Each send is recorded with the token it was given and the sequence it carried
+    std::vector<std::pair<DeliveryToken, uint64_t>> sent;
+    DeliveryToken nextToken = 1;
+    EXPECT_CALL(*mockClient, publishMessage(_, NotNull(), Gt(0), NotNull())).WillRepeatedly([&](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                                                                                             {
+        org_eclipse_tahu_protobuf_Payload payload;
+        EXPECT_GE(decode_payload(&payload, buffer, length), 0);
+        EXPECT_TRUE(payload.has_seq);
+        *token = nextToken++;
+        sent.push_back({*token, payload.seq});
+        free_payload(&payload);
+        return 0; });
+
+    std::vector<std::unique_ptr<Device>> devices;
+    std::vector<std::string> topics;
+    for (int i = 0; i < 3; i++)
+    {
+        devices.push_back(std::make_unique<Device>(("Device" + std::to_string(i)).c_str(), 5));
+        auto metric = Int32Metric::create("Metric", 0);
+        devices.back()->addMetric(metric);
+        metric->setValue(i + 1);
+        topics.push_back("spBv1.0/GroupId/DDATA/NodeId/Device" + std::to_string(i));
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(mockClient->request(new PublishRequest(false, (Publishable *)devices[i].get(), &topics[i], -1, 0)), 0);
+    }
+
+    // The window holds two requests, the third waits in the queue
+    ASSERT_EQ(sent.size(), 2);
+    EXPECT_EQ(sent[0].second, 0);
+    EXPECT_EQ(sent[1].second, 1);
+
+    // A failed request is not sent again until its retry delay has passed, and holds the window while it is outstanding
+    mockClient->onDeliveryFailure(sent[0].first);
+    mockClient->onDelivery(sent[1].first);
+    mockClient->sync();
+    EXPECT_EQ(sent.size(), 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(PUBLISH_RETRY_DELAY + 10));
+    mockClient->sync();
+
+    // The retry keeps its sequence, so the host never sees a sequence sent after a later one
+    ASSERT_EQ(sent.size(), 3);
+    EXPECT_EQ(sent[2].second, 0);
+    EXPECT_EQ(mockClient->getStatistics().retries.get(), 1);
+
+    mockClient->onDelivery(sent[2].first);
+    ASSERT_EQ(sent.size(), 4);
+    EXPECT_EQ(sent[3].second, 2);
+
+    // A publish the client rejects outright is retried after the delay rather than straight away
+    EXPECT_CALL(*mockClient, publishMessage(_, NotNull(), Gt(0), NotNull())).WillOnce(Return(-1)).RetiresOnSaturation();
+    devices[0]->addMetric(Int32Metric::create("Other", 1));
+    EXPECT_EQ(mockClient->request(new PublishRequest(false, (Publishable *)devices[0].get(), &topics[0], -1, 0)), 0);
+    EXPECT_EQ(sent.size(), 4);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(PUBLISH_RETRY_DELAY + 10));
+    mockClient->sync();
+    ASSERT_EQ(sent.size(), 5);
+    EXPECT_EQ(sent[4].second, 3);
+
+    mockClient->onDelivery(sent[3].first);
+    mockClient->onDelivery(sent[4].first);
+    EXPECT_EQ(mockClient->getState(), CONNECTED);
+    node.sync();
+}
+
+TEST(NodeTests, statistics)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+    node.enableStatisticsMetrics();
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+
+    Device device = Device("Device", 5);
+    auto metric = Int32Metric::create("Metric", 0);
+    device.addMetric(metric);
+    metric->setValue(1);
+
+    PublishRequestPool pool;
+    std::string topic = "spBv1.0/GroupId/DDATA/NodeId/Device";
+    ClientStatistics &statistics = mockClient->getStatistics();
+
+    size_t publishedLength = 0;
+    EXPECT_CALL(*mockClient, publishMessage(topic, NotNull(), Gt(0), _))
+        .WillOnce([&publishedLength](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                  { publishedLength = length;
+                    return 0; })
+        .WillOnce(Return(-1))
+        .WillOnce(Return(0));
+
+    PublishRequest *request = pool.acquire(false, (Publishable *)&device, &topic);
+    EXPECT_GT(request->requestTime, 0);
+    EXPECT_EQ(mockClient->processRequest(request), 0);
+    mockClient->deliver(request);
+
+    EXPECT_EQ(statistics.published.get(), 1);
+    EXPECT_EQ(statistics.delivered.get(), 1);
+    EXPECT_EQ(statistics.bytesPublished.get(), publishedLength);
+    EXPECT_EQ(statistics.payloadSize.getMax(), publishedLength);
+    EXPECT_EQ(statistics.encodeTime.getCount(), 1);
+    EXPECT_EQ(statistics.queueLatency.getCount(), 1);
+    EXPECT_EQ(statistics.deliveryLatency.getCount(), 1);
+
+    // A failed publish is not counted as published, and the retry is not counted as queue latency
+    request = pool.acquire(false, (Publishable *)&device, &topic);
+    EXPECT_NE(mockClient->processRequest(request), 0);
+    request->retryCount++;
+    EXPECT_EQ(mockClient->processRequest(request), 0);
+    mockClient->undeliver(request);
+
+    EXPECT_EQ(statistics.published.get(), 2);
+    EXPECT_EQ(statistics.retries.get(), 1);
+    EXPECT_EQ(statistics.undelivered.get(), 1);
+    EXPECT_EQ(statistics.queueLatency.getCount(), 2);
+    EXPECT_EQ(statistics.deliveryLatency.getCount(), 1);
+
+    // The connection, delivery and undelivery events
+    node.sync();
+    EXPECT_EQ(node.getStatistics().eventsProcessed.get(), 3);
+
+    // The statistics metrics are part of the Node birth
+    std::string birthTopic = "spBv1.0/GroupId/NBIRTH/NodeId";
+    PublishRequest birth(true, (Publishable *)&node, &birthTopic, -1, 0);
+
+    std::vector<uint8_t> published;
+    EXPECT_CALL(*mockClient, publishMessage(birthTopic, NotNull(), Gt(0), &birth.token))
+        .WillOnce([&published](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                  { published.assign(buffer, buffer + length);
+                    return 0; });
+    EXPECT_EQ(mockClient->processRequest(&birth), 0);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, published.data(), published.size()), 0);
+    size_t statisticsMetrics = 0;
+    for (size_t i = 0; i < payload.metrics_count; i++)
+    {
+        if (strncmp(payload.metrics[i].name, "Node Statistics/", 16) == 0)
+        {
+            statisticsMetrics++;
+        }
+    }
+    EXPECT_EQ(statisticsMetrics, 9);
+    free_payload(&payload);
+}
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+TEST(NodeTests, scheduledBegin)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 1000, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    std::mutex requestMutex;
+    std::condition_variable requested;
+    vector<PublishRequest *> requests;
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, unsubscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, clientDisconnect()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([&](PublishRequest *publishRequest)
+                                                                {
+        lock_guard<std::mutex> lock(requestMutex);
+        requests.push_back(publishRequest);
+        requested.notify_all();
+        return 0; });
+
+    Device device = Device("Device", 20);
+    auto metric = Int32Metric::create("Metric", 0);
+    device.addMetric(metric);
+    node.addDevice(&device);
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    ASSERT_EQ(requests.size(), 2);
+    for (auto request : requests)
+    {
+        node.onEvent(mockClient, CLIENT_DELIVERED, request->publisher);
+        SparkplugClient::destroyRequest(request);
+    }
+    requests.clear();
+    node.sync();
+
+    metric->setValue(1);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread runner([&node]
+                       { node.begin(); });
+
+    {
+        // The Device is published once its period has passed, while the Node's own period is far longer
+        unique_lock<std::mutex> lock(requestMutex);
+        ASSERT_TRUE(requested.wait_for(lock, std::chrono::seconds(5), [&requests]
+                                       { return !requests.empty(); }));
+        EXPECT_EQ(requests.size(), 1);
+        EXPECT_EQ(requests[0]->publisher, (Publishable *)&device);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(15));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+
+    // Stopping wakes the Node rather than waiting for the next publish
+    start = std::chrono::steady_clock::now();
+    node.stop();
+    runner.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(NODE_SCHEDULER_MAX_WAIT));
+
+    for (auto request : requests)
+    {
+        SparkplugClient::destroyRequest(request);
+    }
+}
+
+TEST(NodeTests, scheduledDirty)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5000, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    std::mutex requestMutex;
+    std::condition_variable requested;
+    vector<PublishRequest *> requests;
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, unsubscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, clientDisconnect()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([&](PublishRequest *publishRequest)
+                                                                {
+        lock_guard<std::mutex> lock(requestMutex);
+        requests.push_back(publishRequest);
+        requested.notify_all();
+        return 0; });
+
+    Device device = Device("Device", 500);
+    auto metric = Int32Metric::create("Metric", 0);
+    metric->setCommandCallback([](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                               { metric->setValue(&payload->value.int_value); });
+    device.addMetric(metric);
+    node.addDevice(&device);
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    ASSERT_EQ(requests.size(), 2);
+    for (auto request : requests)
+    {
+        node.onEvent(mockClient, CLIENT_DELIVERED, request->publisher);
+        SparkplugClient::destroyRequest(request);
+    }
+    requests.clear();
+    node.sync();
+
+    std::thread runner([&node]
+                       { node.begin(); });
+
+    // Once its period has passed the Device can publish, with its timer next due a full period later
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    int32_t commandValue = 7;
+    init_metric(&command, "Metric", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[128];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    MessageEventStruct messageEvent = {
+        "spBv1.0/GroupId/DCMD/NodeId/Device", buffer, (int)length};
+    node.onEvent(mockClient, CLIENT_MESSAGE, &messageEvent);
+
+    {
+        // The changed metric is published straight away rather than when the Device's timer expires
+        unique_lock<std::mutex> lock(requestMutex);
+        ASSERT_TRUE(requested.wait_for(lock, std::chrono::seconds(5), [&requests]
+                                       { return !requests.empty(); }));
+        EXPECT_EQ(requests[0]->publisher, (Publishable *)&device);
+    }
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+
+    node.stop();
+    runner.join();
+
+    for (auto request : requests)
+    {
+        SparkplugClient::destroyRequest(request);
+    }
+}
+#endif
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+TEST(NodeTests, workerThreads)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    vector<PublishRequest *> requests;
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([&requests](PublishRequest *publishRequest)
+                                                                {
+        requests.push_back(publishRequest);
+        return 0; });
+
+    const int deviceCount = 10;
+    std::vector<std::unique_ptr<Device>> devices;
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+
+    for (int i = 0; i < deviceCount; i++)
+    {
+        devices.push_back(std::make_unique<Device>(("Device" + std::to_string(i)).c_str(), 5));
+        metrics.push_back(Int32Metric::create("Metric", 0));
+        devices.back()->addMetric(metrics.back());
+    }
+
+    // Devices added after the workers are configured are sharded as well
+    node.addDevice(devices[0].get());
+    node.setWorkerThreads(3);
+    for (int i = 1; i < deviceCount; i++)
+    {
+        node.addDevice(devices[i].get());
+    }
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    ASSERT_EQ(requests.size(), deviceCount + 1);
+
+    for (auto request : requests)
+    {
+        node.onEvent(mockClient, CLIENT_DELIVERED, request->publisher);
+        SparkplugClient::destroyRequest(request);
+    }
+    requests.clear();
+    node.sync();
+
+    for (int i = 0; i < deviceCount; i++)
+    {
+        metrics[i]->setValue(i + 100);
+    }
+
+    EXPECT_EQ(node.execute(5), 5);
+
+    ASSERT_EQ(requests.size(), deviceCount);
+
+    // Requests are sent in the same order as the serial execute, which is the reverse of the order Devices were added
+    uint64_t expectedSequence = 0;
+    for (int i = 0; i < deviceCount; i++)
+    {
+        PublishRequest *request = requests[i];
+        int device = deviceCount - 1 - i;
+
+        EXPECT_FALSE(request->isBirth);
+        EXPECT_EQ(request->publisher, (Publishable *)devices[device].get());
+        EXPECT_GT(request->encodedLength, 0);
+
+        std::vector<uint8_t> published;
+        EXPECT_CALL(*mockClient, publishMessage(*request->topic, NotNull(), Gt(request->encodedLength), &request->token))
+            .WillOnce([&published](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                      { published.assign(buffer, buffer + length);
+                        return 0; });
+
+        // A retried send keeps its sequence rather than appending another
+        int attempts = i == 0 ? 2 : 1;
+        if (attempts > 1)
+        {
+            EXPECT_CALL(*mockClient, publishMessage(*request->topic, NotNull(), Gt(request->encodedLength), &request->token))
+                .WillOnce(Return(-1))
+                .RetiresOnSaturation();
+        }
+
+        for (int attempt = 0; attempt < attempts; attempt++)
+        {
+            mockClient->processRequest(request);
+        }
+
+        org_eclipse_tahu_protobuf_Payload payload;
+        ASSERT_GE(decode_payload(&payload, published.data(), published.size()), 0);
+        EXPECT_TRUE(payload.has_seq);
+        EXPECT_EQ(payload.seq, expectedSequence++);
+        ASSERT_EQ(payload.metrics_count, 1);
+        EXPECT_EQ(payload.metrics[0].value.int_value, device + 100);
+        free_payload(&payload);
+    }
+
+    for (auto request : requests)
+    {
+        node.onEvent(mockClient, CLIENT_DELIVERED, request->publisher);
+        SparkplugClient::destroyRequest(request);
+    }
+    requests.clear();
+    node.sync();
+
+    // Disabling the workers returns to the serial execute
+    node.setWorkerThreads(0);
+    metrics[0]->setValue(1);
+    node.execute(5);
+    ASSERT_EQ(requests.size(), 1);
+    EXPECT_EQ(requests[0]->encodedLength, 0);
+    SparkplugClient::destroyRequest(requests[0]);
+}
+
+TEST(NodeTests, workerThreadsBegin)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5000, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    std::mutex requestMutex;
+    std::condition_variable requested;
+    vector<PublishRequest *> requests;
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, subscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, unsubscribeToCommands()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, clientDisconnect()).WillOnce(Return(0));
+    EXPECT_CALL(*mockClient, request(NotNull())).WillRepeatedly([&](PublishRequest *publishRequest)
+                                                                {
+        lock_guard<std::mutex> lock(requestMutex);
+        requests.push_back(publishRequest);
+        requested.notify_all();
+        return 0; });
+
+    const int deviceCount = 4;
+    std::vector<std::unique_ptr<Device>> devices;
+    std::vector<std::shared_ptr<Int32Metric>> metrics;
+
+    for (int i = 0; i < deviceCount; i++)
+    {
+        devices.push_back(std::make_unique<Device>(("Device" + std::to_string(i)).c_str(), 20));
+        metrics.push_back(Int32Metric::create("Metric", 0));
+        devices.back()->addMetric(metrics.back());
+        node.addDevice(devices.back().get());
+    }
+    node.setWorkerThreads(2);
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+    node.sync();
+    mockClient->active();
+    node.sync();
+
+    ASSERT_EQ(requests.size(), deviceCount + 1);
+    for (auto request : requests)
+    {
+        node.onEvent(mockClient, CLIENT_DELIVERED, request->publisher);
+        SparkplugClient::destroyRequest(request);
+    }
+    requests.clear();
+    node.sync();
+
+    for (int i = 0; i < deviceCount; i++)
+    {
+        metrics[i]->setValue(i + 100);
+    }
+
+    std::thread runner([&node]
+                       { node.begin(); });
+
+    {
+        // Devices whose timers expire are encoded by the workers, so their requests arrive already encoded
+        unique_lock<std::mutex> lock(requestMutex);
+        ASSERT_TRUE(requested.wait_for(lock, std::chrono::seconds(5), [&requests]
+                                       { return requests.size() >= deviceCount; }));
+        for (auto request : requests)
+        {
+            EXPECT_NE(request->publisher, (Publishable *)&node);
+            EXPECT_GT(request->encodedLength, 0);
+        }
+    }
+
+    node.stop();
+    runner.join();
+
+    for (auto request : requests)
+    {
+        SparkplugClient::destroyRequest(request);
+    }
+}
+#endif
+
+#ifdef CPP_SPARKPLUG_COMPRESSION
+TEST(NodeTests, compressedBirth)
+{
+    NodeOptions nodeOptions = {
+        "GroupId", "NodeId", "", 5, NODE_CONTROL_NONE};
+
+    Node node = Node(&nodeOptions);
+
+    ClientOptions clientOptions = {
+        .address = CLIENT_ADDRESS,
+        .clientId = CLIENT_CLIENT_ID,
+        .username = NULL,
+        .password = NULL,
+        .connectTimeout = 60,
+        .keepAliveInterval = 5};
+
+    MockSparkplugClient *mockClient;
+
+    mockClient = (MockSparkplugClient *)node.addClient<MockSparkplugClient>(&clientOptions);
+
+    EXPECT_CALL(*mockClient, configureClient(&clientOptions)).WillOnce(Return(0));
+
+    EXPECT_EQ(node.enable(), ENABLE_SUCCESS);
+
+    mockClient->connect();
+
+    Device device = Device("Device", 5);
+
+    for (int i = 0; i < 100; i++)
+    {
+        device.addMetric(Int32Metric::create(("Metric/" + std::to_string(i)).c_str(), i));
+    }
+
+    std::string topic = "spBv1.0/GroupId/DBIRTH/NodeId/Device";
+    PublishRequest request(true, (Publishable *)&device, &topic, -1, 0);
+
+    size_t uncompressedLength = 0;
+    EXPECT_CALL(*mockClient, publishMessage(topic, NotNull(), Gt(0), &request.token))
+        .WillOnce([&uncompressedLength](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                  { uncompressedLength = length;
+                    return 0; });
+    EXPECT_EQ(mockClient->processRequest(&request), 0);
+
+    mockClient->enableCompression(COMPRESSION_DEFLATE, 256);
+
+    std::vector<uint8_t> published;
+    EXPECT_CALL(*mockClient, publishMessage(topic, NotNull(), Gt(0), &request.token))
+        .WillOnce([&published](std::string topic, uint8_t *buffer, size_t length, DeliveryToken *token)
+                  { published.assign(buffer, buffer + length);
+                    return 0; });
+    EXPECT_EQ(mockClient->processRequest(&request), 0);
+
+    EXPECT_LT(published.size(), uncompressedLength);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, published.data(), published.size()), 0);
+    EXPECT_STREQ(payload.uuid, SPARKPLUG_COMPRESSED_UUID);
+    ASSERT_EQ(payload.metrics_count, 1);
+    EXPECT_STREQ(payload.metrics[0].name, SPARKPLUG_COMPRESSION_ALGORITHM_METRIC);
+    EXPECT_STREQ(payload.metrics[0].value.string_value, "DEFLATE");
+
+    std::vector<uint8_t> decompressed;
+    ASSERT_NE(payload.body, nullptr);
+    ASSERT_EQ(decompressBody(payload.metrics[0].value.string_value, payload.body->bytes, payload.body->size, decompressed), 0);
+    free_payload(&payload);
+    ASSERT_GE(decode_payload(&payload, decompressed.data(), decompressed.size()), 0);
+    EXPECT_EQ(payload.uuid, nullptr);
+    EXPECT_EQ(payload.metrics_count, 100);
+    free_payload(&payload);
+}
+#endif
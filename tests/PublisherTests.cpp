@@ -34,7 +34,18 @@
 #include <tahu.h>
 
 #include "Device.h"
+#include "metrics/simple/DoubleMetric.h"
 #include "metrics/simple/Int32Metric.h"
+#include "metrics/simple/StringMetric.h"
+#include "utils/MockTimeManager.h"
+#include "properties/simple/UInt8Property.h"
+#ifdef CPP_SPARKPLUG_COMPRESSION
+#include "utils/Compression.h"
+#include <zlib.h>
+#endif
+#ifdef _GLIBCXX_HAS_GTHREADS
+#include <thread>
+#endif
 
 TEST(Publishable, TestUpdate)
 {
@@ -83,4 +94,596 @@ TEST(Publishable, TestCanPublish)
 
     EXPECT_EQ(testPublishable.update(30), 30);
     EXPECT_TRUE(testPublishable.canPublish());
-}
\ No newline at end of file
+}
+TEST(Publishable, TestAliases)
+{
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 20);
+    auto secondMetric = Int32Metric::create("Second", 30);
+
+    testPublishable.addMetrics({firstMetric, secondMetric});
+
+    EXPECT_NE(firstMetric->getAlias(), 0);
+    EXPECT_NE(secondMetric->getAlias(), 0);
+    EXPECT_NE(firstMetric->getAlias(), secondMetric->getAlias());
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+
+    // Births carry both the name and alias
+    testPublishable.addToPayload(&payload, true);
+    ASSERT_EQ(payload.metrics_count, 2);
+    EXPECT_STREQ(payload.metrics[1].name, "First");
+    EXPECT_TRUE(payload.metrics[1].has_alias);
+    EXPECT_EQ(payload.metrics[1].alias, firstMetric->getAlias());
+
+    // Data messages only carry the alias
+    firstMetric->setValue(21);
+    testPublishable.addToPayload(&payload);
+    ASSERT_EQ(payload.metrics_count, 3);
+    EXPECT_EQ(payload.metrics[2].name, nullptr);
+    EXPECT_TRUE(payload.metrics[2].has_alias);
+    EXPECT_EQ(payload.metrics[2].alias, firstMetric->getAlias());
+    EXPECT_EQ(payload.metrics[2].value.int_value, 21);
+
+    free_payload(&payload);
+
+    // Commands addressed by alias alone reach the metric
+    int32_t receivedValue = 0;
+    secondMetric->setCommandCallback([&receivedValue](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                                     { receivedValue = payload->value.int_value; });
+
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    int32_t commandValue = 45;
+    init_metric(&command, NULL, true, secondMetric->getAlias(), METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[128];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    ((Publishable *)&testPublishable)->handleCommand(NULL, buffer, length);
+
+    EXPECT_EQ(receivedValue, 45);
+}
+
+TEST(Publishable, TestCommandLookup)
+{
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 20);
+    testPublishable.addMetric(firstMetric);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+    testPublishable.addToPayload(&payload, true);
+    free_payload(&payload);
+
+    // Metrics added after a birth should still receive commands
+    auto lateMetric = Int32Metric::create("Late", 0);
+    testPublishable.addMetric(lateMetric);
+
+    int32_t firstValue = 0, lateValue = 0;
+    firstMetric->setCommandCallback([&firstValue](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                                    { firstValue = payload->value.int_value; });
+    lateMetric->setCommandCallback([&lateValue](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                                   { lateValue = payload->value.int_value; });
+
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    int32_t commandValue = 7;
+    init_metric(&command, "Late", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+    commandValue = 9;
+    init_metric(&command, "Unknown", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[128];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    ((Publishable *)&testPublishable)->handleCommand(NULL, buffer, length);
+
+    EXPECT_EQ(lateValue, 7);
+    EXPECT_EQ(firstValue, 0);
+}
+
+TEST(Publishable, TestStreamingCommand)
+{
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 0);
+    auto secondMetric = Int32Metric::create("Second", 0);
+    testPublishable.addMetrics({firstMetric, secondMetric});
+
+    std::vector<int32_t> received;
+    auto callback = [&received](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+    {
+        received.push_back(payload->value.int_value);
+    };
+    firstMetric->setCommandCallback(callback);
+    secondMetric->setCommandCallback(callback);
+
+    // Unknown metrics, including their properties and string values, are skipped without being decoded
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    init_metric(&command, "Unknown", false, 0, METRIC_DATA_TYPE_STRING, false, false, "Value", 6);
+    org_eclipse_tahu_protobuf_Payload_PropertySet propertySet;
+    memset(&propertySet, 0, sizeof(propertySet));
+    uint8_t propertyValue = 1;
+    add_property_to_set(&propertySet, "Property", PROPERTY_DATA_TYPE_UINT8, &propertyValue, sizeof(propertyValue));
+    add_propertyset_to_metric(&command, &propertySet);
+    add_metric_to_payload(&payload, &command);
+
+    int32_t commandValue = 1;
+    init_metric(&command, "First", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+    commandValue = 2;
+    init_metric(&command, NULL, true, secondMetric->getAlias(), METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[256];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    ((Publishable *)&testPublishable)->handleCommand(NULL, buffer, length);
+
+    // Commands are dispatched last to first
+    ASSERT_EQ(received.size(), 2);
+    EXPECT_EQ(received[0], 2);
+    EXPECT_EQ(received[1], 1);
+
+    // Truncated payloads are dropped without dispatching any command
+    received.clear();
+    ((Publishable *)&testPublishable)->handleCommand(NULL, buffer, length - 1);
+    EXPECT_TRUE(received.empty());
+}
+
+TEST(Publishable, TestInPlaceCommand)
+{
+    Device testPublishable = Device("name", 30);
+    auto stringMetric = StringMetric::create("String", "");
+    auto doubleMetric = DoubleMetric::create("Double", 0);
+    auto propertyMetric = Int32Metric::create("Property", 0);
+    testPublishable.addMetrics({stringMetric, doubleMetric, propertyMetric});
+
+    std::vector<std::string> names;
+    std::string stringValue;
+    double doubleValue = 0;
+    uint64_t timestamp = 0;
+    int32_t propertyValue = 0;
+    auto callback = [&](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+    {
+        names.push_back(payload->name != NULL ? payload->name : "(null)");
+        timestamp = payload->timestamp;
+        if (metric == stringMetric.get())
+        {
+            stringValue = payload->value.string_value;
+        }
+        else if (metric == doubleMetric.get())
+        {
+            doubleValue = payload->value.double_value;
+        }
+        else
+        {
+            propertyValue = payload->properties.keys_count == 1 ? payload->value.int_value : -1;
+        }
+    };
+    stringMetric->setCommandCallback(callback);
+    doubleMetric->setCommandCallback(callback);
+    propertyMetric->setCommandCallback(callback);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    init_metric(&command, "String", false, 0, METRIC_DATA_TYPE_STRING, false, false, "Value", 6);
+    command.has_timestamp = true;
+    command.timestamp = 1234;
+    add_metric_to_payload(&payload, &command);
+
+    double commandDouble = 2.5;
+    init_metric(&command, NULL, true, doubleMetric->getAlias(), METRIC_DATA_TYPE_DOUBLE, false, false, &commandDouble, sizeof(commandDouble));
+    add_metric_to_payload(&payload, &command);
+
+    // Metrics with nested messages are still decoded by nanopb
+    int32_t commandInt = 7;
+    init_metric(&command, "Property", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandInt, sizeof(commandInt));
+    org_eclipse_tahu_protobuf_Payload_PropertySet propertySet;
+    memset(&propertySet, 0, sizeof(propertySet));
+    uint8_t property = 1;
+    add_property_to_set(&propertySet, "Property", PROPERTY_DATA_TYPE_UINT8, &property, sizeof(property));
+    add_propertyset_to_metric(&command, &propertySet);
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[256];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    ((Publishable *)&testPublishable)->handleCommand(NULL, buffer, length);
+
+    ASSERT_EQ(names.size(), 3);
+    EXPECT_EQ(names[0], "Property");
+    EXPECT_EQ(names[1], "(null)");
+    EXPECT_EQ(names[2], "String");
+    EXPECT_EQ(propertyValue, 7);
+    EXPECT_EQ(doubleValue, 2.5);
+    EXPECT_EQ(stringValue, "Value");
+    EXPECT_EQ(timestamp, 1234);
+}
+
+TEST(Publishable, TestDirtyTracking)
+{
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 1);
+    auto secondMetric = Int32Metric::create("Second", 2);
+    auto thirdMetric = Int32Metric::create("Third", 3);
+
+    // Metrics that are dirty before being added are tracked
+    thirdMetric->setValue(4);
+
+    testPublishable.addMetrics({firstMetric, secondMetric, thirdMetric});
+
+    EXPECT_EQ(testPublishable.update(30), 30);
+    EXPECT_TRUE(testPublishable.canPublish());
+
+    secondMetric->setValue(5);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+
+    // Only the dirty metrics are added to a data payload
+    testPublishable.addToPayload(&payload);
+    EXPECT_EQ(payload.metrics_count, 2);
+    free_payload(&payload);
+
+    testPublishable.published();
+    EXPECT_FALSE(firstMetric->isDirty());
+    EXPECT_FALSE(secondMetric->isDirty());
+    EXPECT_FALSE(thirdMetric->isDirty());
+
+    EXPECT_EQ(testPublishable.update(30), 30);
+    EXPECT_FALSE(testPublishable.canPublish());
+
+    firstMetric->setValue(6);
+    EXPECT_TRUE(testPublishable.canPublish());
+
+    // Births still contain every metric
+    get_next_payload(&payload);
+    testPublishable.addToPayload(&payload, true);
+    EXPECT_EQ(payload.metrics_count, 3);
+    free_payload(&payload);
+
+    testPublishable.published();
+    EXPECT_FALSE(firstMetric->isDirty());
+    EXPECT_EQ(testPublishable.update(30), 30);
+    EXPECT_FALSE(testPublishable.canPublish());
+}
+
+TEST(Publishable, TestHeldMetrics)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+
+    Device testPublishable = Device("name", 5000);
+    auto metric = Int32Metric::create("Metric", 1);
+    metric->setMinimumInterval(1000);
+    testPublishable.addMetric(metric);
+
+    // A change within the minimum interval is held back, and the Publishable is updated again when the interval ends
+    mockManager.setTime(100);
+    metric->setValue(2);
+    EXPECT_FALSE(metric->isDirty());
+    EXPECT_EQ(testPublishable.update(100), 900);
+
+    mockManager.setTime(600);
+    EXPECT_EQ(testPublishable.update(500), 400);
+    EXPECT_FALSE(metric->isDirty());
+
+    // Once the interval has passed the held change is published without another change to the metric
+    mockManager.setTime(1000);
+    EXPECT_EQ(testPublishable.update(400), 4000);
+    EXPECT_TRUE(metric->isDirty());
+
+    testPublishable.published();
+    EXPECT_FALSE(metric->isDirty());
+    EXPECT_EQ(testPublishable.update(0), 4000);
+
+    TimeManager::setInstance(NULL);
+}
+
+TEST(Publishable, TestUpdateMetrics)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+    mockManager.setTime(1000);
+
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 1);
+    auto secondMetric = Int32Metric::create("Second", 2);
+    auto thirdMetric = Int32Metric::create("Third", 3);
+
+    testPublishable.addMetrics({firstMetric, secondMetric, thirdMetric});
+
+    std::vector<MetricUpdate<int32_t>> updates = {
+        {firstMetric.get(), 10},
+        {secondMetric.get(), 2},
+        {thirdMetric.get(), 30}};
+
+    // Unchanged metrics are not marked dirty
+    EXPECT_EQ(testPublishable.updateMetrics(updates), 2);
+    EXPECT_TRUE(firstMetric->isDirty());
+    EXPECT_FALSE(secondMetric->isDirty());
+    EXPECT_TRUE(thirdMetric->isDirty());
+
+    EXPECT_EQ(testPublishable.update(30), 30);
+    EXPECT_TRUE(testPublishable.canPublish());
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+
+    // Every change shares the time the batch was applied
+    testPublishable.addToPayload(&payload);
+    ASSERT_EQ(payload.metrics_count, 2);
+    for (size_t i = 0; i < payload.metrics_count; i++)
+    {
+        EXPECT_EQ(payload.metrics[i].timestamp, 1000);
+    }
+    free_payload(&payload);
+
+    testPublishable.published();
+    EXPECT_EQ(testPublishable.updateMetrics(updates), 0);
+    EXPECT_FALSE(testPublishable.canPublish());
+
+    // A batch holding a metric of another Publishable is rejected without storing any value
+    Device otherPublishable = Device("other", 30);
+    auto otherMetric = Int32Metric::create("Other", 4);
+    otherPublishable.addMetric(otherMetric);
+
+    std::vector<MetricUpdate<int32_t>> mixedUpdates = {
+        {firstMetric.get(), 11},
+        {otherMetric.get(), 40}};
+
+    EXPECT_EQ(testPublishable.updateMetrics(mixedUpdates), -1);
+    EXPECT_EQ(*(int32_t *)firstMetric->getData(), 10);
+    EXPECT_FALSE(firstMetric->isDirty());
+    EXPECT_EQ(*(int32_t *)otherMetric->getData(), 4);
+
+    // As is a batch holding a NULL metric
+    std::vector<MetricUpdate<int32_t>> nullUpdates = {
+        {firstMetric.get(), 12},
+        {NULL, 50}};
+
+    EXPECT_EQ(testPublishable.updateMetrics(nullUpdates), -1);
+    EXPECT_EQ(*(int32_t *)firstMetric->getData(), 10);
+    EXPECT_FALSE(firstMetric->isDirty());
+
+    TimeManager::setInstance(NULL);
+}
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+TEST(Publishable, TestSetValueFromThread)
+{
+    Device testPublishable = Device("name", 0);
+    auto intMetric = Int32Metric::create("Int", 0);
+    auto stringMetric = StringMetric::create("String", "");
+    testPublishable.addMetrics({intMetric, stringMetric});
+
+    // Metrics are set on another thread while their Publishable is updated, encoded and published
+    std::thread setter([&]()
+                       {
+        for (int32_t i = 1; i <= 10000; i++)
+        {
+            intMetric->setValue(i);
+            stringMetric->setValue(std::string(i % 64, 'x'));
+        } });
+
+    std::vector<uint8_t> buffer;
+    for (int i = 0; i < 1000; i++)
+    {
+        testPublishable.update(0);
+        EXPECT_EQ(testPublishable.encodeData(buffer, 0), 0);
+        testPublishable.published();
+    }
+    setter.join();
+
+    // The dirty list is intact, so the next change is published
+    testPublishable.published();
+    EXPECT_FALSE(intMetric->isDirty());
+    intMetric->setValue(-1);
+    ASSERT_EQ(testPublishable.encodeData(buffer, 0), 0);
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, buffer.data(), buffer.size()), 0);
+    ASSERT_EQ(payload.metrics_count, 1);
+    EXPECT_EQ((int32_t)payload.metrics[0].value.int_value, -1);
+    free_payload(&payload);
+}
+#endif
+
+TEST(Publishable, TestEncodeBirth)
+{
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 1);
+    auto secondMetric = Int32Metric::create("Second", 2);
+    auto property = UInt8Property::create("Property", 3);
+    secondMetric->addProperty(property);
+
+    // Births are encoded from the cache for the second metric, and straight from the value for the first
+    EXPECT_EQ(secondMetric->enableBirthCache(true), 0);
+
+    testPublishable.addMetrics({firstMetric, secondMetric});
+
+    auto decodeBirth = [&testPublishable](uint64_t timestamp, int32_t first, int32_t second, uint8_t propertyValue)
+    {
+        std::vector<uint8_t> buffer;
+        ASSERT_EQ(testPublishable.encodeBirth(buffer, timestamp), 0);
+
+        org_eclipse_tahu_protobuf_Payload payload;
+        ASSERT_GE(decode_payload(&payload, buffer.data(), buffer.size()), 0);
+        EXPECT_FALSE(payload.has_seq);
+        EXPECT_EQ(payload.timestamp, timestamp);
+        ASSERT_EQ(payload.metrics_count, 2);
+
+        for (size_t i = 0; i < payload.metrics_count; i++)
+        {
+            org_eclipse_tahu_protobuf_Payload_Metric &metric = payload.metrics[i];
+            EXPECT_TRUE(metric.has_timestamp);
+            EXPECT_EQ(metric.timestamp, timestamp);
+            EXPECT_TRUE(metric.has_alias);
+
+            if (strcmp(metric.name, "First") == 0)
+            {
+                EXPECT_EQ(metric.value.int_value, first);
+            }
+            else
+            {
+                EXPECT_STREQ(metric.name, "Second");
+                EXPECT_EQ(metric.value.int_value, second);
+                ASSERT_TRUE(metric.has_properties);
+                ASSERT_EQ(metric.properties.values_count, 1);
+                EXPECT_EQ(metric.properties.values[0].value.int_value, propertyValue);
+            }
+        }
+        free_payload(&payload);
+    };
+
+    decodeBirth(100, 1, 2, 3);
+
+    // Only the timestamps differ between births of an unchanged Publishable
+    decodeBirth(200, 1, 2, 3);
+
+    // Changed values and properties are encoded again, whether or not they have been published
+    firstMetric->setValue(10);
+    decodeBirth(300, 10, 2, 3);
+
+    testPublishable.published();
+    property->setValue(4);
+    decodeBirth(400, 10, 2, 4);
+
+    testPublishable.published();
+    secondMetric->setValue(20);
+    testPublishable.published();
+    decodeBirth(500, 10, 20, 4);
+}
+
+TEST(Publishable, TestEncodeData)
+{
+    MockTimeManager mockManager;
+    TimeManager::setInstance((TimeClient *)&mockManager);
+
+    Device testPublishable = Device("name", 30);
+    auto firstMetric = Int32Metric::create("First", 1);
+    auto secondMetric = Int32Metric::create("Second", 2);
+    auto property = UInt8Property::create("Property", 3);
+    secondMetric->addProperty(property);
+
+    testPublishable.addMetrics({firstMetric, secondMetric});
+
+    mockManager.setTime(100);
+    secondMetric->setValue(20);
+    property->setValue(4);
+
+    std::vector<uint8_t> buffer;
+    ASSERT_EQ(testPublishable.encodeData(buffer, 200), 0);
+
+    // Only the dirty metric is encoded, by its alias
+    org_eclipse_tahu_protobuf_Payload payload;
+    ASSERT_GE(decode_payload(&payload, buffer.data(), buffer.size()), 0);
+    EXPECT_FALSE(payload.has_seq);
+    EXPECT_EQ(payload.timestamp, 200);
+    ASSERT_EQ(payload.metrics_count, 1);
+
+    org_eclipse_tahu_protobuf_Payload_Metric &metric = payload.metrics[0];
+    EXPECT_EQ(metric.name, nullptr);
+    EXPECT_EQ(metric.alias, secondMetric->getAlias());
+    EXPECT_EQ(metric.timestamp, 100);
+    EXPECT_EQ(metric.value.int_value, 20);
+    ASSERT_TRUE(metric.has_properties);
+    ASSERT_EQ(metric.properties.values_count, 1);
+    EXPECT_STREQ(metric.properties.keys[0], "Property");
+    EXPECT_EQ(metric.properties.values[0].value.int_value, 4);
+    free_payload(&payload);
+
+    // The streamed payload matches the struct form of the payload
+    memset(&payload, 0, sizeof(payload));
+    payload.has_timestamp = true;
+    payload.timestamp = 200;
+    testPublishable.addToPayload(&payload);
+    std::vector<uint8_t> expected(encode_payload(NULL, 0, &payload));
+    EXPECT_EQ(encode_payload(expected.data(), expected.size(), &payload), (ssize_t)expected.size());
+    EXPECT_EQ(buffer, expected);
+    free_payload(&payload);
+
+    TimeManager::reset();
+}
+
+#ifdef CPP_SPARKPLUG_COMPRESSION
+TEST(Publishable, TestCompressedCommand)
+{
+    Device testPublishable = Device("name", 30);
+    auto metric = Int32Metric::create("Metric", 0);
+    testPublishable.addMetric(metric);
+
+    int32_t value = 0;
+    metric->setCommandCallback([&value](Metric *metric, org_eclipse_tahu_protobuf_Payload_Metric *payload)
+                               { value = payload->value.int_value; });
+
+    org_eclipse_tahu_protobuf_Payload payload;
+    get_next_payload(&payload);
+    org_eclipse_tahu_protobuf_Payload_Metric command;
+    int32_t commandValue = 5;
+    init_metric(&command, "Metric", false, 0, METRIC_DATA_TYPE_INT32, false, false, &commandValue, sizeof(commandValue));
+    add_metric_to_payload(&payload, &command);
+
+    uint8_t buffer[128];
+    ssize_t length = encode_payload(buffer, sizeof(buffer), &payload);
+    free_payload(&payload);
+    ASSERT_GT(length, 0);
+
+    for (auto algorithm : {COMPRESSION_DEFLATE, COMPRESSION_GZIP})
+    {
+        value = 0;
+
+        org_eclipse_tahu_protobuf_Payload envelope;
+        ASSERT_EQ(compressPayload(algorithm, buffer, length, &envelope), 0);
+        EXPECT_STREQ(envelope.uuid, SPARKPLUG_COMPRESSED_UUID);
+
+        uint8_t compressed[256];
+        ssize_t compressedLength = encode_payload(compressed, sizeof(compressed), &envelope);
+        free_payload(&envelope);
+        ASSERT_GT(compressedLength, 0);
+
+        ((Publishable *)&testPublishable)->handleCommand(NULL, compressed, compressedLength);
+
+        EXPECT_EQ(value, 5);
+    }
+}
+
+TEST(Publishable, TestDecompressLimit)
+{
+    // A body of zeros inflates to far more than it takes to send
+    std::vector<uint8_t> inflated(COMPRESSION_MAX_DECOMPRESSED_SIZE + 1, 0);
+    std::vector<uint8_t> body(compressBound(inflated.size()));
+    uLongf bodyLength = body.size();
+    ASSERT_EQ(compress(body.data(), &bodyLength, inflated.data(), inflated.size()), Z_OK);
+    ASSERT_LT(bodyLength, 4096u);
+
+    std::vector<uint8_t> decompressed;
+    EXPECT_EQ(decompressBody("DEFLATE", body.data(), bodyLength, decompressed), -1);
+    EXPECT_LE(decompressed.size(), (size_t)COMPRESSION_MAX_DECOMPRESSED_SIZE);
+
+    // A body that inflates to exactly the limit is accepted
+    EXPECT_EQ(decompressBody("DEFLATE", body.data(), bodyLength, decompressed, inflated.size()), 0);
+    EXPECT_EQ(decompressed.size(), inflated.size());
+
+    org_eclipse_tahu_protobuf_Payload envelope;
+    ASSERT_EQ(compressPayload(COMPRESSION_GZIP, inflated.data(), 2048, &envelope), 0);
+    ASSERT_NE(envelope.body, nullptr);
+    EXPECT_EQ(decompressBody("GZIP", envelope.body->bytes, envelope.body->size, decompressed, 1024), -1);
+    free_payload(&envelope);
+}
+#endif
@@ -0,0 +1,456 @@
+/*
+ * File: UtilsTests.cpp
+ * Project: cpp_sparkplug
+ * Created Date: Saturday October 17th 2026
+ * Author: Kyle Hofer
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Kyle Hofer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * HISTORY:
+ */
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+#include <filesystem>
+
+#include "utils/MpscQueue.h"
+#include "utils/PublishRequestPool.h"
+#include "utils/TimerWheel.h"
+#include "utils/Statistics.h"
+#include "clients/SparkplugClient.h"
+#ifdef CPP_SPARKPLUG_SPOOL
+#include "utils/Spool.h"
+#endif
+
+TEST(MpscQueue, TestPushPop)
+{
+    MpscQueue<int, 4> queue;
+    int value;
+
+    EXPECT_FALSE(queue.pop(value));
+
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(queue.push(i));
+    }
+
+    // Queue is full
+    EXPECT_FALSE(queue.push(4));
+
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 0);
+
+    EXPECT_TRUE(queue.push(4));
+
+    int items[8];
+    EXPECT_EQ(queue.drain(items, 8), 4);
+
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(items[i], i + 1);
+    }
+
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(MpscQueue, TestMultipleProducers)
+{
+    const int PRODUCERS = 4;
+    const int ITEMS = 10000;
+
+    MpscQueue<int, 64> queue;
+    std::vector<std::thread> producers;
+
+    for (int producer = 0; producer < PRODUCERS; producer++)
+    {
+        producers.emplace_back(
+            [&queue, producer]()
+            {
+                for (int i = 0; i < ITEMS; i++)
+                {
+                    while (!queue.push(producer * ITEMS + i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+
+    // Each producer's items must arrive in the order they were pushed
+    std::vector<int> last(PRODUCERS, -1);
+    int received = 0;
+    int value;
+
+    while (received < PRODUCERS * ITEMS)
+    {
+        if (!queue.pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        int producer = value / ITEMS;
+        EXPECT_GT(value % ITEMS, last[producer]);
+        last[producer] = value % ITEMS;
+        received++;
+    }
+
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(PublishRequestPool, TestRecycle)
+{
+    PublishRequestPool pool;
+    std::string topic = "spBv1.0/GroupId/NDATA/NodeId";
+    std::vector<PublishRequest *> requests;
+
+    for (int i = 0; i < PUBLISH_REQUEST_POOL_SIZE; i++)
+    {
+        PublishRequest *request = pool.acquire(false, NULL, &topic);
+        EXPECT_EQ(request->pool, &pool);
+        EXPECT_EQ(request->topic, &topic);
+        EXPECT_EQ(request->token, -1);
+        requests.push_back(request);
+    }
+
+    // Once exhausted requests fall back to the heap
+    PublishRequest *heapRequest = pool.acquire(true, NULL, &topic);
+    EXPECT_EQ(heapRequest->pool, nullptr);
+    EXPECT_TRUE(heapRequest->isBirth);
+    SparkplugClient::destroyRequest(heapRequest);
+
+    PublishRequest *released = requests.front();
+    released->token = 10;
+    released->retryCount = 2;
+    SparkplugClient::destroyRequest(released);
+
+    PublishRequest *recycled = pool.acquire(true, NULL, &topic);
+    EXPECT_EQ(recycled, released);
+    EXPECT_EQ(recycled->token, -1);
+    EXPECT_EQ(recycled->retryCount, 0);
+    EXPECT_TRUE(recycled->isBirth);
+
+    // Small payload buffers are kept for the next publish, large ones are freed
+    recycled->encoded.resize(PUBLISH_REQUEST_POOL_MAX_RETAINED);
+    SparkplugClient::destroyRequest(recycled);
+    recycled = pool.acquire(false, NULL, &topic);
+    EXPECT_EQ(recycled->encoded.capacity(), PUBLISH_REQUEST_POOL_MAX_RETAINED);
+
+    recycled->encoded.resize(PUBLISH_REQUEST_POOL_MAX_RETAINED + 1);
+    SparkplugClient::destroyRequest(recycled);
+    recycled = pool.acquire(false, NULL, &topic);
+    EXPECT_EQ(recycled->encoded.capacity(), 0);
+}
+
+TEST(TimerWheel, TestExpiry)
+{
+    TimerWheel wheel(1000);
+    TimerWheel::Timer timers[5];
+
+    EXPECT_TRUE(wheel.isEmpty());
+    EXPECT_EQ(wheel.nextDue(), UINT64_MAX);
+
+    // Timers spread across every level of the wheel, and one beyond its range
+    uint64_t dues[5] = {1005, 1070, 6000, 301000, 1000 + (1ULL << 30)};
+    for (int i = 4; i >= 0; i--)
+    {
+        wheel.schedule(&timers[i], dues[i]);
+        EXPECT_TRUE(timers[i].isScheduled());
+    }
+
+    EXPECT_EQ(wheel.nextDue(), 1005);
+
+    for (int i = 0; i < 5; i++)
+    {
+        // Nothing expires early
+        EXPECT_EQ(wheel.advance(dues[i] - 1), nullptr);
+
+        uint64_t now = dues[i] - 1;
+        while (wheel.nextDue() <= now)
+        {
+            EXPECT_EQ(wheel.advance(now), nullptr);
+        }
+
+        TimerWheel::Timer *expired = wheel.advance(dues[i]);
+        ASSERT_EQ(expired, &timers[i]);
+        EXPECT_EQ(expired->next, nullptr);
+        EXPECT_FALSE(expired->isScheduled());
+    }
+
+    EXPECT_TRUE(wheel.isEmpty());
+}
+
+TEST(TimerWheel, TestOrderAndCancel)
+{
+    TimerWheel wheel(0);
+    TimerWheel::Timer timers[4];
+
+    wheel.schedule(&timers[0], 300);
+    wheel.schedule(&timers[1], 10);
+    wheel.schedule(&timers[2], 200);
+    wheel.schedule(&timers[3], 50);
+
+    // Rescheduling moves a timer, cancelling removes it
+    wheel.schedule(&timers[1], 100);
+    wheel.cancel(&timers[2]);
+    EXPECT_FALSE(timers[2].isScheduled());
+
+    // Timers scheduled in the past expire on the next advance
+    wheel.advance(20);
+    wheel.schedule(&timers[2], 5);
+
+    TimerWheel::Timer *expired = wheel.advance(1000);
+    std::vector<TimerWheel::Timer *> order;
+    for (; expired != nullptr; expired = expired->next)
+    {
+        order.push_back(expired);
+    }
+
+    std::vector<TimerWheel::Timer *> expected = {&timers[2], &timers[3], &timers[1], &timers[0]};
+    EXPECT_EQ(order, expected);
+    EXPECT_TRUE(wheel.isEmpty());
+}
+
+TEST(TimerWheel, TestCascadeBoundary)
+{
+    TimerWheel wheel(0);
+    TimerWheel::Timer first, second;
+
+    // The second timer cascades on the same tick the first expires before
+    wheel.schedule(&first, 63);
+    wheel.schedule(&second, 100);
+
+    TimerWheel::Timer *expired = wheel.advance(200);
+    ASSERT_EQ(expired, &first);
+    EXPECT_EQ(expired->next, &second);
+    EXPECT_TRUE(wheel.isEmpty());
+}
+
+TEST(Statistics, TestHistogram)
+{
+    StatisticsHistogram histogram;
+
+    EXPECT_EQ(histogram.getPercentile(0.5), 0);
+    EXPECT_EQ(StatisticsHistogram::bucketOf(0), 0);
+    EXPECT_EQ(StatisticsHistogram::bucketOf(1), 1);
+    EXPECT_EQ(StatisticsHistogram::bucketOf(1023), 10);
+    EXPECT_EQ(StatisticsHistogram::bucketOf(1024), 11);
+    EXPECT_EQ(StatisticsHistogram::bucketOf(UINT64_MAX), STATISTICS_HISTOGRAM_BUCKETS - 1);
+
+    for (uint64_t i = 1; i <= 100; i++)
+    {
+        histogram.record(i);
+    }
+    histogram.record(5000);
+
+    EXPECT_EQ(histogram.getCount(), 101);
+    EXPECT_EQ(histogram.getSum(), 10050);
+    EXPECT_EQ(histogram.getMax(), 5000);
+    EXPECT_EQ(histogram.getMean(), 99);
+    EXPECT_EQ(histogram.getBucket(7), 37);
+
+    // Percentiles are bounded by the bucket they fall in
+    EXPECT_EQ(histogram.getPercentile(0.5), 63);
+    EXPECT_EQ(histogram.getPercentile(0.99), 127);
+    EXPECT_EQ(histogram.getPercentile(1), 5000);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.getCount(), 0);
+    EXPECT_EQ(histogram.getMax(), 0);
+}
+
+TEST(Statistics, TestConcurrentRecord)
+{
+    StatisticsCounter counter;
+    StatisticsGauge gauge;
+    StatisticsHistogram histogram;
+
+    auto record = [&](uint64_t offset)
+    {
+        for (uint64_t i = 0; i < 10000; i++)
+        {
+            counter.add();
+            gauge.set(offset + i);
+            histogram.record(i);
+        }
+    };
+
+#ifdef _GLIBCXX_HAS_GTHREADS
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < 4; i++)
+    {
+        threads.emplace_back(record, i);
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+#else
+    for (uint64_t i = 0; i < 4; i++)
+    {
+        record(i);
+    }
+#endif
+
+    EXPECT_EQ(counter.get(), 40000);
+    EXPECT_EQ(gauge.getMax(), 10002);
+    EXPECT_EQ(histogram.getCount(), 40000);
+    EXPECT_EQ(histogram.getSum(), 4 * 49995000ULL);
+    EXPECT_EQ(histogram.getMax(), 9999);
+}
+
+#ifdef CPP_SPARKPLUG_SPOOL
+TEST(Spool, TestAppendReplay)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cpp_sparkplug_spool_test";
+    std::filesystem::remove_all(directory);
+
+    std::string_view topic;
+    const uint8_t *payload;
+    size_t length;
+
+    {
+        Spool spool;
+        ASSERT_EQ(spool.open(directory.c_str(), 64 * 1024), 0);
+        EXPECT_TRUE(spool.isEmpty());
+        EXPECT_FALSE(spool.peek(topic, payload, length));
+
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            uint8_t data[4] = {i, i, i, i};
+            EXPECT_EQ(spool.append("spBv1.0/GroupId/NDATA/NodeId", data, sizeof(data)), 0);
+        }
+
+        ASSERT_TRUE(spool.peek(topic, payload, length));
+        EXPECT_EQ(topic, "spBv1.0/GroupId/NDATA/NodeId");
+        EXPECT_EQ(length, 4);
+        EXPECT_EQ(payload[0], 0);
+        spool.pop();
+    }
+
+    {
+        // Records that have not been replayed survive the spool being reopened
+        Spool spool;
+        ASSERT_EQ(spool.open(directory.c_str(), 64 * 1024), 0);
+
+        for (uint8_t i = 1; i < 3; i++)
+        {
+            ASSERT_TRUE(spool.peek(topic, payload, length));
+            EXPECT_EQ(payload[0], i);
+            spool.pop();
+        }
+
+        EXPECT_TRUE(spool.isEmpty());
+        EXPECT_FALSE(spool.peek(topic, payload, length));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(Spool, TestSizeCap)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cpp_sparkplug_spool_cap_test";
+    std::filesystem::remove_all(directory);
+
+    const size_t maxBytes = 1024;
+    Spool spool;
+    ASSERT_EQ(spool.open(directory.c_str(), maxBytes), 0);
+
+    uint8_t data[200];
+
+    for (int i = 0; i < 20; i++)
+    {
+        memset(data, i, sizeof(data));
+        EXPECT_EQ(spool.append("topic", data, sizeof(data)), 0);
+        EXPECT_LE(spool.size(), maxBytes);
+    }
+
+    // Records larger than the spool can never be stored
+    uint8_t large[2048] = {0};
+    EXPECT_EQ(spool.append("topic", large, sizeof(large)), -1);
+
+    // The oldest records were dropped, but the newest are kept in order
+    std::string_view topic;
+    const uint8_t *payload;
+    size_t length;
+    int last = -1;
+
+    while (spool.peek(topic, payload, length))
+    {
+        EXPECT_GT(payload[0], last);
+        last = payload[0];
+        spool.pop();
+    }
+
+    EXPECT_EQ(last, 19);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(Spool, TestPopAfterDrop)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cpp_sparkplug_spool_drop_test";
+    std::filesystem::remove_all(directory);
+
+    Spool spool;
+    ASSERT_EQ(spool.open(directory.c_str(), 1024), 0);
+
+    std::string_view topic;
+    const uint8_t *payload;
+    size_t length;
+    uint8_t data[200];
+
+    memset(data, 0, sizeof(data));
+    EXPECT_EQ(spool.append("topic", data, sizeof(data)), 0);
+    ASSERT_TRUE(spool.peek(topic, payload, length));
+    EXPECT_EQ(payload[0], 0);
+
+    // The record being replayed is dropped to make room for newer records
+    for (uint8_t i = 1; i < 8; i++)
+    {
+        memset(data, i, sizeof(data));
+        EXPECT_EQ(spool.append("topic", data, sizeof(data)), 0);
+    }
+
+    // Popping only removes the record that was peeked, so the oldest record that was never replayed is kept.
+    // Each segment holds four records, so the first segment was dropped when the fifth record was appended.
+    spool.pop();
+    ASSERT_TRUE(spool.peek(topic, payload, length));
+    EXPECT_EQ(payload[0], 4);
+
+    // Popping twice removes the peeked record only once
+    spool.pop();
+    spool.pop();
+    ASSERT_TRUE(spool.peek(topic, payload, length));
+    EXPECT_EQ(payload[0], 5);
+
+    std::filesystem::remove_all(directory);
+}
+#endif
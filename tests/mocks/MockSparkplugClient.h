@@ -76,6 +76,16 @@ public:
         return SparkplugClient::processRequest(publishRequest);
     }
 
+    void deliver(PublishRequest *publishRequest)
+    {
+        SparkplugClient::delivered(publishRequest);
+    }
+
+    void undeliver(PublishRequest *publishRequest)
+    {
+        SparkplugClient::undelivered(publishRequest);
+    }
+
     virtual void sync() override
     {
     }